@@ -367,11 +367,14 @@ static int init_home_dir(void)
  * @param context
  * Unused at the moment
  *
- * @param str
+ * @param data
  * The console output to display
+ *
+ * @param size
+ * The number of bytes of console output
  */
-static void console_output(void *context, const std::string &str) {
-    if_print(str.c_str());
+static void console_output(void *context, const char *data, size_t size) {
+    if_print_data(data, size);
 }
 
 static void command_response(void *context, struct tgdb_response *response);
@@ -488,6 +491,15 @@ static void update_breakpoints(struct tgdb_response *response)
     if_show_file(NULL, 0, 0);
 }
 
+/* This updates the breakpoints that changed */
+static void update_breakpoint_changes(struct tgdb_response *response)
+{
+    source_change_breakpoints(if_get_sview(),
+        response->choice.update_breakpoint_changes.removed,
+        response->choice.update_breakpoint_changes.added);
+    if_show_file(NULL, 0, 0);
+}
+
 /* This means a source file or line number changed */
 static void update_file_position(struct tgdb_response *response)
 {
@@ -553,7 +565,7 @@ static void update_file_position(struct tgdb_response *response)
             if_draw();
         } else if (sview->addr_frame) {
             /* No disasm found - request it */
-            tgdb_request_disassemble_func(tgdb,
+            tgdb_request_disassemble_func(tgdb, sview->addr_frame,
                 DISASSEMBLE_FUNC_SOURCE_LINES);
             // If the disassembly view was not available and is attempting
             // to be loaded, then reload the breakpoints afterwards, so they
@@ -566,7 +578,7 @@ static void update_file_position(struct tgdb_response *response)
 /* This is a list of all the source files */
 static void update_source_files(struct tgdb_response *response)
 {
-    char **source_files = response->choice.update_source_files.source_files;
+    const char **source_files = response->choice.update_source_files.source_files;
     sviewer *sview = if_get_sview();
     struct list_node *cur;
     int added_disasm = 0;
@@ -612,7 +624,8 @@ static void update_disassemble(struct tgdb_response *response)
             if_print_message("\nWarning: disassemble address 0x%" PRIx64 " failed.\n",
                 response->choice.disassemble_function.addr_start);
         } else {
-            tgdb_request_disassemble_pc(tgdb, 100);
+            tgdb_request_disassemble_pc(tgdb,
+                response->choice.disassemble_function.addr_start, 100);
         }
     } else {
         uint64_t addr_start = response->choice.disassemble_function.addr_start;
@@ -670,6 +683,9 @@ static void command_response(void *context, struct tgdb_response *response)
     case TGDB_UPDATE_BREAKPOINTS:
         update_breakpoints(response);
         break;
+    case TGDB_UPDATE_BREAKPOINT_CHANGES:
+        update_breakpoint_changes(response);
+        break;
     case TGDB_UPDATE_FILE_POSITION:
         update_file_position(response);
         break;
@@ -764,7 +780,7 @@ static int cgdb_handle_signal_in_main_loop(int fd)
 
 static int main_loop(void)
 {
-    fd_set rset;
+    fd_set rset, wset;
     int max;
 
     /* Main (infinite) loop:
@@ -787,8 +803,15 @@ static int main_loop(void)
         FD_SET(signal_pipe[0], &rset);
         FD_SET(gdb_mi_fd, &rset);
 
+        /* Wait for gdb to accept the data queued for it, if any */
+        FD_ZERO(&wset);
+        if (tgdb_pending_write_size(tgdb, gdb_console_fd) > 0)
+            FD_SET(gdb_console_fd, &wset);
+        if (tgdb_pending_write_size(tgdb, gdb_mi_fd) > 0)
+            FD_SET(gdb_mi_fd, &wset);
+
         /* Wait for input */
-        if (select(max + 1, &rset, NULL, NULL, NULL) == -1) {
+        if (select(max + 1, &rset, &wset, NULL, NULL) == -1) {
             if (errno == EINTR)
                 continue;
             else {
@@ -844,6 +867,18 @@ static int main_loop(void)
                 return -1;
             }
         }
+
+        /* gdb is ready for more of the data queued for it */
+        if (FD_ISSET(gdb_console_fd, &wset))
+            if (tgdb_process_writable(tgdb, gdb_console_fd) == -1)
+                return -1;
+
+        if (FD_ISSET(gdb_mi_fd, &wset))
+            if (tgdb_process_writable(tgdb, gdb_mi_fd) == -1)
+                return -1;
+
+        if_set_gdb_backlog(tgdb_pending_write_size(tgdb, gdb_console_fd) +
+                tgdb_pending_write_size(tgdb, gdb_mi_fd));
     }
     return 0;
 }
@@ -75,6 +75,7 @@ static int command_focus_gdb(int param);
 static int command_do_bang(int param);
 static int command_do_focus(int param);
 static int command_do_help(int param);
+static int command_do_latency(int param);
 static int command_do_logo(int param);
 static int command_do_quit(int param);
 static int command_do_shell(int param);
@@ -101,6 +102,7 @@ COMMANDS commands[] = {
     /* focus        */ {"focus", (action_t)command_do_focus, 0},
     /* help         */ {"help", (action_t)command_do_help, 0},
     /* logo         */ {"logo", (action_t)command_do_logo, 0},
+    /* latency      */ {"latency", (action_t)command_do_latency, 0},
     /* highlight    */ {"highlight", (action_t)command_parse_highlight, 0},
     /* highlight    */ {"hi", (action_t)command_parse_highlight, 0},
     /* imap         */ {"imap", (action_t)command_parse_map, 0},
@@ -723,6 +725,23 @@ int command_do_help(int param)
     return 0;
 }
 
+int command_do_latency(int param)
+{
+    std::string stats = tgdb_get_request_stats(tgdb);
+    std::string text = "\r\n";
+    size_t i;
+
+    /* The gdb window is a terminal, so each line needs a carriage return */
+    for (i = 0; i < stats.size(); ++i) {
+        if (stats[i] == '\n')
+            text.push_back('\r');
+        text.push_back(stats[i]);
+    }
+
+    if_print(text.c_str());
+    return 0;
+}
+
 int command_do_logo(int param)
 {
     if_display_logo(1);
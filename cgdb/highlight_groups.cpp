@@ -838,6 +838,64 @@ int ansi_get_closest_color_value(int r, int g, int b)
     return index;
 }
 
+/* Given a 256-color palette index, return the closest color in our 16 entry
+ * color table. The 6x6x6 color cube and the grayscale ramp are mapped once
+ * and then looked up. */
+int hl_ansi_get_closest_color_index(int num)
+{
+    static int color_table_inited = 0;
+    static unsigned char color_table[256];
+
+    if (!color_table_inited) {
+        for (int i = 0; i < 256; i++) {
+            int index = i;
+
+            if (i >= 232) {
+                /* Convert grayscale 232 - 255 value to 0 - 255 rgb value */
+                int gray = 255 * (i - 232) / (255 - 232);
+                index = ansi_get_closest_color_value(gray, gray, gray);
+            } else if (i >= 16) {
+                /* Convert 0-6 component values to 0 - 255 rgb values */
+                int red = ((i - 16) / 36);
+                int green = (((i - 16) - red * 36) / 6);
+                int blue = ((i - 16) % 6);
+                index = ansi_get_closest_color_value(red * 255 / 6,
+                        green * 255 / 6, blue * 255 / 6);
+            }
+
+            color_table[i] = (unsigned char)index;
+        }
+
+        color_table_inited = 1;
+    }
+
+    return color_table[MAX(0, MIN(num, 255))];
+}
+
+/* Given a 24-bit rgb value, return the closest color in our 16 entry color
+ * table. Programs emitting truecolor tend to reuse a handful of colors, so
+ * the results are remembered in a small direct mapped cache. */
+int hl_ansi_get_closest_rgb_index(int r, int g, int b)
+{
+    static struct
+    {
+        /* The rgb value with bit 24 set, 0 when the slot is empty */
+        unsigned int key;
+        int index;
+    } rgb_cache[256];
+
+    unsigned int rgb = ((r & 0xff) << 16) | ((g & 0xff) << 8) | (b & 0xff);
+    unsigned int key = rgb | 0x1000000;
+    unsigned int slot = (rgb * 2654435761u) >> 24;
+
+    if (rgb_cache[slot].key != key) {
+        rgb_cache[slot].key = key;
+        rgb_cache[slot].index = ansi_get_closest_color_value(r, g, b);
+    }
+
+    return rgb_cache[slot].index;
+}
+
 /*
    In 256-color mode, the color-codes are the following:
 
@@ -864,16 +922,8 @@ static int ansi_get_color_code_index(const char *buf, int *index)
             i++;
         }
 
-        if (num >= 232) {
-            /* Convert grayscale 232 - 255 value to 0 - 255 rgb value */
-            int gray = 255 * (MIN(num, 255) - 232) / (255 - 232);
-            num = ansi_get_closest_color_value( gray, gray, gray );
-        } else if (num >= 16) {
-            /* Convert 0-6 component values to 0 - 255 rgb values */
-            int red = ((num - 16) / 36);
-            int green = (((num - 16) - red * 36) / 6);
-            int blue = ((num - 16) % 6);
-            num = ansi_get_closest_color_value( red * 255 / 6, green * 255 / 6, blue * 255 / 6 );
+        if (num >= 16) {
+            num = hl_ansi_get_closest_color_index(num);
         }
 
         *index = num;
@@ -325,6 +325,34 @@ void hl_printline_highlight(SWINDOW *win, const char *line, int line_len,
  * The attribute associated with the color pair
  */
 void hl_get_color_attr_from_index(int fg_index, int bg_index, int &attr);
+
+/**
+ * Map a 256-color palette index to the closest of the 16 ansi colors.
+ *
+ * @param num
+ * The palette index, 0 through 255
+ *
+ * @return
+ * The closest color, 0 through 15
+ */
+int hl_ansi_get_closest_color_index(int num);
+
+/**
+ * Map a 24-bit rgb color to the closest of the 16 ansi colors.
+ *
+ * @param r
+ * The red component, 0 through 255
+ *
+ * @param g
+ * The green component, 0 through 255
+ *
+ * @param b
+ * The blue component, 0 through 255
+ *
+ * @return
+ * The closest color, 0 through 15
+ */
+int hl_ansi_get_closest_rgb_index(int r, int g, int b);
 /*@}*/
 /* }}}*/
 
@@ -130,6 +130,7 @@ static SWINDOW *status_win = NULL;   /* The status line */
 static SWINDOW *vseparator_win = NULL;   /* Separator gets own window */
 static enum Focus focus = GDB;  /* Which pane is currently focused */
 static struct winsize screen_size;  /* Screen size */
+static size_t gdb_backlog = 0;  /* Bytes gdb has not read from cgdb yet */
 
 struct filedlg *fd;             /* The file dialog structure */
 
@@ -424,7 +425,14 @@ static void update_status_win(enum win_refresh dorefresh)
         /* Print filename */
         const char *filename = source_current_file(src_viewer);
 
-        if (filename) {
+        /* Let the user know gdb is not keeping up with its input */
+        if (gdb_backlog > 0) {
+            char header[64];
+
+            snprintf(header, sizeof(header), "[%lu bytes queued for gdb] ",
+                    (unsigned long)gdb_backlog);
+            if_display_message(dorefresh, header, filename ? filename : "");
+        } else if (filename) {
             if_display_message(dorefresh, "", filename);
         }
     }
@@ -507,6 +515,15 @@ void if_draw(void)
     swin_doupdate();
 }
 
+void if_set_gdb_backlog(size_t size)
+{
+    if (size == gdb_backlog)
+        return;
+
+    gdb_backlog = size;
+    if_draw();
+}
+
 /* validate_window_sizes:
  * ----------------------
  *
@@ -1502,15 +1519,15 @@ int if_input(int key)
     return result;
 }
 
-static void if_print_internal(const char *buf)
+static void if_print_internal(const char *buf, size_t size)
 {
     if (!gdb_scroller) {
-        clog_error(CLOG_CGDB, "%s", buf);
+        clog_error(CLOG_CGDB, "%.*s", (int)size, buf);
         return;
     }
 
     /* Print it to the scroller */
-    scr_add(gdb_scroller, buf);
+    scr_add(gdb_scroller, buf, size);
 
     if (get_gdb_height() > 0) {
         scr_refresh(gdb_scroller, focus == GDB, WIN_NO_REFRESH);
@@ -1526,7 +1543,12 @@ static void if_print_internal(const char *buf)
 
 void if_print(const char *buf)
 {
-    if_print_internal(buf);
+    if_print_internal(buf, strlen(buf));
+}
+
+void if_print_data(const char *buf, size_t size)
+{
+    if_print_internal(buf, size);
 }
 
 void if_sdc_print(const char *buf)
@@ -1551,7 +1573,7 @@ void if_print_message(const char *fmt, ...)
     if_print(va_buf);
 }
 
-void if_show_file(char *path, int sel_line, int exe_line)
+void if_show_file(const char *path, int sel_line, int exe_line)
 {
     if (source_set_exec_line(src_viewer, path, sel_line, exe_line) == 0)
         if_draw();
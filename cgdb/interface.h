@@ -50,6 +50,14 @@ int if_input(int key);
  */
 void if_print(const char *buf);
 
+/* if_print_data: Prints data to the GDB input/output window.
+ * --------------
+ *
+ *   buf:  The buffer to display, it does not need to be NULL-terminated.
+ *   size: The number of bytes in buf.
+ */
+void if_print_data(const char *buf, size_t size);
+
 /* if_print_message: Prints data to the GDB input/output window.
  * -----------------
  *
@@ -72,7 +80,7 @@ void if_sdc_print(const char *command);
  *   sel_line:  Current line of the file being selected (0 to leave unchanged)
  *   exe_line:  Current line of the file being executed (0 to leave unchanged)
  */
-void if_show_file(char *path, int sel_line, int exe_line);
+void if_show_file(const char *path, int sel_line, int exe_line);
 
 /* if_get_sview: Return a pointer to the source viewer object.
  * -------------
@@ -176,6 +184,14 @@ void if_search_next(void);
  */
 void if_draw(void);
 
+/* if_set_gdb_backlog: Shows how much input gdb has not read yet.
+ * -------------------
+ *
+ *   size: The number of bytes waiting to be written to gdb. The status
+ *         bar only shows the backlog while this is not 0.
+ */
+void if_set_gdb_backlog(size_t size);
+
  /**
   * Set the window split orientation. (vertical or horizontal)
   *
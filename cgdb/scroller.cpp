@@ -290,9 +290,9 @@ void scr_push_screen_to_scrollback(struct scroller *scr)
     vterminal_push_screen_to_scrollback(scr->vt);
 }
 
-void scr_add(struct scroller *scr, const char *buf)
+void scr_add(struct scroller *scr, const char *buf, size_t size)
 {
-    vterminal_write(scr->vt, buf, strlen(buf));
+    vterminal_write(scr->vt, buf, size);
 }
 
 void scr_move(struct scroller *scr, SWINDOW *win)
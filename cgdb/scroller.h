@@ -173,7 +173,10 @@ void scr_push_screen_to_scrollback(struct scroller *scr);
 //
 // @param buf
 // The buffer to append
-void scr_add(struct scroller *scr, const char *buf);
+//
+// @param size
+// The number of bytes in buf
+void scr_add(struct scroller *scr, const char *buf, size_t size);
 
 // Give the scroller a new window to display itself in
 //
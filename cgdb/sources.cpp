@@ -1342,11 +1342,54 @@ static void source_clear_breaks(struct sviewer *sview)
     }
 }
 
+/**
+ * Mark the source and disassembly lines of a breakpoint location.
+ *
+ * @param sview
+ * The source viewer object
+ *
+ * @param breakpoint
+ * The breakpoint location to mark
+ *
+ * @param status
+ * The status to give the lines
+ */
+static void source_mark_breakpoint(struct sviewer *sview,
+        const struct tgdb_breakpoint &breakpoint,
+        enum line_flags::breakpt_status status)
+{
+    struct list_node *node;
+
+    if (breakpoint.path) {
+        node = source_get_node(sview, breakpoint.path);
+        if (!load_file(node)) {
+            int line = breakpoint.line;
+            if (line > 0 && line <= node->lflags.size()) {
+                node->lflags[line - 1].breakpt = status;
+            }
+        }
+    }
+    if (breakpoint.addr) {
+        int line = 0;
+        node = source_get_asmnode(sview, breakpoint.addr, &line);
+        if (node) {
+            node->lflags[line].breakpt = status;
+        }
+    }
+}
+
+static enum line_flags::breakpt_status source_breakpoint_status(
+        const struct tgdb_breakpoint &breakpoint)
+{
+    return breakpoint.enabled
+        ? line_flags::breakpt_status::enabled
+        : line_flags::breakpt_status::disabled;
+}
+
 void source_set_breakpoints(struct sviewer *sview,
         struct tgdb_breakpoint *breakpoints)
 {
     int i;
-    struct list_node *node;
 
     source_clear_breaks(sview);
 
@@ -1355,27 +1398,24 @@ void source_set_breakpoints(struct sviewer *sview,
     // in one mode, then switch modes, the other mode will know about
     // it as well.
     for (i = 0; i < sbcount(breakpoints); i++) {
-        if (breakpoints[i].path) {
-            node = source_get_node(sview, breakpoints[i].path);
-            if (!load_file(node)) {
-                int line = breakpoints[i].line;
-                int enabled = breakpoints[i].enabled;
-                if (line > 0 && line <= node->lflags.size()) {
-                    node->lflags[line - 1].breakpt = enabled
-                        ? line_flags::breakpt_status::enabled
-                        : line_flags::breakpt_status::disabled;
-                }
-            }
-        }
-        if (breakpoints[i].addr) {
-            int line = 0;
-            node = source_get_asmnode(sview, breakpoints[i].addr, &line);
-            if (node) {
-                node->lflags[line].breakpt = breakpoints[i].enabled
-                    ? line_flags::breakpt_status::enabled
-                    : line_flags::breakpt_status::disabled;
-            }
-        }
+        source_mark_breakpoint(sview, breakpoints[i],
+                source_breakpoint_status(breakpoints[i]));
+    }
+}
+
+void source_change_breakpoints(struct sviewer *sview,
+        struct tgdb_breakpoint *removed, struct tgdb_breakpoint *added)
+{
+    int i;
+
+    for (i = 0; i < sbcount(removed); i++) {
+        source_mark_breakpoint(sview, removed[i],
+                line_flags::breakpt_status::none);
+    }
+
+    for (i = 0; i < sbcount(added); i++) {
+        source_mark_breakpoint(sview, added[i],
+                source_breakpoint_status(added[i]));
     }
 }
 
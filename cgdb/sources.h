@@ -290,6 +290,21 @@ void source_free(struct sviewer *sview);
 void source_set_breakpoints(struct sviewer *sview,
         struct tgdb_breakpoint *breakpoints);
 
+/**
+ * Apply breakpoint changes without touching unaffected lines.
+ *
+ * @param sview
+ * The source viewer object
+ *
+ * @param removed
+ * The breakpoint locations to unmark
+ *
+ * @param added
+ * The breakpoint locations to mark, applied after removed
+ */
+void source_change_breakpoints(struct sviewer *sview,
+        struct tgdb_breakpoint *removed, struct tgdb_breakpoint *added);
+
 /**
  * Check's to see if the current source file has changed. If it has it loads
  * the new source file up.
@@ -1,3 +1,6 @@
+#include <map>
+#include <vector>
+
 #include "vterminal.h"
 // To use fill_utf8 
 #include "utf8.h"
@@ -9,13 +12,165 @@
 #include "highlight_groups.h"
 
 // The scrollback buffer data structure
-typedef struct {
+typedef struct ScrollbackLine {
     // The number of cells in the list below
     size_t cols;
+    // The next free row in the pool bucket, only valid while released
+    struct ScrollbackLine *next_free;
     // A list of cells
     VTermScreenCell cells[];
 } ScrollbackLine;
 
+// A pool allocator for scrollback rows
+//
+// Rows are carved out of slabs that hold SB_POOL_SLAB_ROWS rows of the
+// same column count. Released rows are kept on a free list per column
+// count and handed out again by the next allocation of that size, so
+// steady state terminal output does not call malloc.
+//
+// A bucket is only ever freed as a whole, either when all of its rows
+// have been released and its column count is stale (after a resize),
+// or when the pool itself is destroyed.
+struct ScrollbackPool
+{
+    ScrollbackPool() : cur_cols(0) {}
+    ~ScrollbackPool();
+
+    // Allocate a scrollback row
+    //
+    // @param cols
+    // The number of cells the row must hold
+    //
+    // @return
+    // The new row, with the cols field set
+    ScrollbackLine *alloc(size_t cols);
+
+    // Return a scrollback row to the pool
+    //
+    // @param row
+    // A row previously returned by alloc
+    void release(ScrollbackLine *row);
+
+    // Free every bucket that has no rows in use and does not match cols
+    //
+    // @param cols
+    // The current width of the terminal
+    void trim(size_t cols);
+
+    enum { SB_POOL_SLAB_ROWS = 64 };
+
+    struct Bucket
+    {
+        Bucket() : free_list(nullptr), live(0) {}
+
+        // The slabs allocated for this column count
+        std::vector<char *> slabs;
+        // The rows available for reuse
+        ScrollbackLine *free_list;
+        // The number of rows currently handed out
+        size_t live;
+    };
+
+    // Release all the slabs in a bucket
+    static void free_bucket(Bucket &bucket);
+
+    // The number of bytes a single row of cols cells occupies in a slab
+    static size_t row_stride(size_t cols);
+
+    // The buckets, keyed by column count
+    std::map<size_t, Bucket> buckets;
+
+    // The column count of the most recent allocation
+    size_t cur_cols;
+};
+
+ScrollbackPool::~ScrollbackPool()
+{
+    std::map<size_t, Bucket>::iterator iter;
+    for (iter = buckets.begin(); iter != buckets.end(); ++iter) {
+        free_bucket(iter->second);
+    }
+}
+
+size_t
+ScrollbackPool::row_stride(size_t cols)
+{
+    size_t align = alignof(ScrollbackLine);
+    size_t size = sizeof(ScrollbackLine) + cols * sizeof(VTermScreenCell);
+    return (size + align - 1) / align * align;
+}
+
+void
+ScrollbackPool::free_bucket(Bucket &bucket)
+{
+    for (size_t i = 0; i < bucket.slabs.size(); ++i) {
+        free(bucket.slabs[i]);
+    }
+    bucket.slabs.clear();
+    bucket.free_list = nullptr;
+}
+
+ScrollbackLine *
+ScrollbackPool::alloc(size_t cols)
+{
+    Bucket &bucket = buckets[cols];
+    cur_cols = cols;
+
+    if (!bucket.free_list) {
+        // Carve a new slab into rows and thread them onto the free list
+        size_t stride = row_stride(cols);
+        char *slab = (char *)cgdb_malloc(stride * SB_POOL_SLAB_ROWS);
+        bucket.slabs.push_back(slab);
+
+        for (int i = SB_POOL_SLAB_ROWS - 1; i >= 0; --i) {
+            ScrollbackLine *row = (ScrollbackLine *)(slab + stride * i);
+            row->cols = cols;
+            row->next_free = bucket.free_list;
+            bucket.free_list = row;
+        }
+    }
+
+    ScrollbackLine *row = bucket.free_list;
+    bucket.free_list = row->next_free;
+    row->next_free = nullptr;
+    bucket.live++;
+
+    return row;
+}
+
+void
+ScrollbackPool::release(ScrollbackLine *row)
+{
+    std::map<size_t, Bucket>::iterator iter = buckets.find(row->cols);
+    Bucket &bucket = iter->second;
+
+    row->next_free = bucket.free_list;
+    bucket.free_list = row;
+    bucket.live--;
+
+    // The last row of a stale width was released, drop the whole bucket
+    if (bucket.live == 0 && row->cols != cur_cols) {
+        free_bucket(bucket);
+        buckets.erase(iter);
+    }
+}
+
+void
+ScrollbackPool::trim(size_t cols)
+{
+    cur_cols = cols;
+
+    std::map<size_t, Bucket>::iterator iter = buckets.begin();
+    while (iter != buckets.end()) {
+        if (iter->second.live == 0 && iter->first != cols) {
+            free_bucket(iter->second);
+            iter = buckets.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
 struct VTerminal
 {
     VTerminal(VTerminalOptions options);
@@ -131,6 +286,9 @@ struct VTerminal
     // Scrollback buffer storage
     ScrollbackLine **sb_buffer;
 
+    // The allocator the rows in sb_buffer come from
+    ScrollbackPool sb_pool;
+
     // Number of rows pushed to sb_buffer.
     // Does not include rows in vterm currently.
     size_t sb_current;
@@ -210,9 +368,7 @@ VTerminal::VTerminal(VTerminalOptions options) : vt(nullptr)
 
 VTerminal::~VTerminal()
 {
-    for (size_t i = 0; i < sb_current; i++) {
-      free(sb_buffer[i]);
-    }
+    // The rows in sb_buffer are released along with sb_pool
     free(sb_buffer);
     vterm_free(vt);
 }
@@ -222,6 +378,9 @@ VTerminal::resize(int height, int width)
 {
     vterm_set_size(vt, height, width);
     vterm_screen_flush_damage(vts);
+
+    // Rows of the old width that are no longer referenced can go now
+    sb_pool.trim((size_t)width);
 }
 
 void
@@ -276,7 +435,7 @@ VTerminal::sb_pushline(int cols, const VTermScreenCell *cells)
             // Recycle old row if it's the right size
             sbrow = sb_buffer[sb_current - 1];
         } else {
-            free(sb_buffer[sb_current - 1]);
+            sb_pool.release(sb_buffer[sb_current - 1]);
         }
 
         // Make room at the start by shifting to the right.
@@ -288,9 +447,7 @@ VTerminal::sb_pushline(int cols, const VTermScreenCell *cells)
     }
 
     if (!sbrow) {
-        sbrow = (ScrollbackLine *)malloc(
-            sizeof(ScrollbackLine) + c * sizeof(sbrow->cells[0]));
-        sbrow->cols = c;
+        sbrow = sb_pool.alloc(c);
     }
 
     // New row is added at the start of the storage buffer.
@@ -329,13 +486,11 @@ VTerminal::sb_popline(int cols, VTermScreenCell *cells)
         cells[col].width = 1;
     }
 
-    free(sbrow);
+    sb_pool.release(sbrow);
 
     return 1;
 }
 
-int ansi_get_closest_color_value(int r, int g, int b);
-
 static int get_ncurses_color_index(VTermColor &color, bool &bold)
 {
     int index = -1;
@@ -346,31 +501,19 @@ static int get_ncurses_color_index(VTermColor &color, bool &bold)
     } else if (VTERM_COLOR_IS_DEFAULT_BG(&color)) {
         index = -1;
     } else if (VTERM_COLOR_IS_INDEXED(&color)) {
-        if (color.indexed.idx >= 0 && color.indexed.idx < 16) {
-            index = color.indexed.idx;
-        } else if (color.indexed.idx >=232) {
-            int num = color.indexed.idx;
-            int gray = 255 * (MIN(num, 255) - 232) / (255 - 232);
-            index = ansi_get_closest_color_value( gray, gray, gray );
-        } else if (color.indexed.idx >= 16) {
-            int num = color.indexed.idx;
-            int red = ((num - 16) / 36);
-            int green = (((num - 16) - red * 36) / 6);
-            int blue = ((num - 16) % 6);
-            index = ansi_get_closest_color_value( red * 255 / 6,
-                    green * 255 / 6, blue * 255 / 6 );
-        }
-
-        // Colors 8 through 15 are high intensity colors
-        // To my knowledge, the only way to handle this with ncurses is
-        // to bold the corresponding low intensity numbers.
-        // https://en.wikipedia.org/wiki/ANSI_escape_code
-        if (index >=8 && index < 16) {
-            index = index - 8;
-            bold = true;
-        }
+        index = hl_ansi_get_closest_color_index(color.indexed.idx);
     } else if (VTERM_COLOR_IS_RGB(&color)) {
-        // TODO: RGB is currently unsupported
+        index = hl_ansi_get_closest_rgb_index(color.rgb.red,
+                color.rgb.green, color.rgb.blue);
+    }
+
+    // Colors 8 through 15 are high intensity colors
+    // To my knowledge, the only way to handle this with ncurses is
+    // to bold the corresponding low intensity numbers.
+    // https://en.wikipedia.org/wiki/ANSI_escape_code
+    if (index >=8 && index < 16) {
+        index = index - 8;
+        bold = true;
     }
     return index;
 }
@@ -388,7 +531,6 @@ VTerminal::fetch_row(int row, int start_col, int end_col, int &attr, int &width)
     VTermScreenCell cell;
     fetch_cell(row, col, &cell);
 
-    // TODO: What about rgb colors?
     bool fg_bold = false, bg_bold = false;
     int fg_index = get_ncurses_color_index(cell.fg, fg_bold);
     int bg_index = get_ncurses_color_index(cell.bg, bg_bold);
@@ -43,6 +43,20 @@
 #include <stdlib.h>
 #endif /* HAVE_STDLIB_H */
 
+#if HAVE_FCNTL_H
+#include <fcntl.h>
+#endif /* HAVE_FCNTL_H */
+
+#include <poll.h>
+#include <sys/socket.h>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
 /* Local includes */
 #include "tgdb.h"
 #include "io.h"
@@ -60,6 +74,9 @@ static int gdb_quit = 0;
 /* Original terminal attributes */
 static struct termios term_attributes;
 
+/* Set when replaying, the console output is not shown then */
+static int replaying = 0;
+
 static void start_logging()
 {
     /* Open our cgdb and tgdb io logfiles */
@@ -162,7 +179,7 @@ static int stdin_input()
 int main_loop(int gdbfd, int mifd)
 {
     int max;
-    fd_set rfds;
+    fd_set rfds, wfds;
     int result;
 
     while (!gdb_quit) {
@@ -184,7 +201,14 @@ int main_loop(int gdbfd, int mifd)
         FD_SET(gdbfd, &rfds);
         FD_SET(mifd, &rfds);
 
-        result = select(max + 1, &rfds, NULL, NULL, NULL);
+        /* Wait for gdb to accept the data queued for it, if any */
+        FD_ZERO(&wfds);
+        if (tgdb_pending_write_size(tgdb, gdbfd) > 0)
+            FD_SET(gdbfd, &wfds);
+        if (tgdb_pending_write_size(tgdb, mifd) > 0)
+            FD_SET(mifd, &wfds);
+
+        result = select(max + 1, &rfds, &wfds, NULL, NULL);
 
         /* if the signal interrupted system call keep going */
         if (result == -1 && errno == EINTR)
@@ -207,17 +231,26 @@ int main_loop(int gdbfd, int mifd)
             if (gdb_input(mifd) == -1)
                 return -1;
         }
+
+        /* tgdb's queued input -> gdb */
+        if (FD_ISSET(gdbfd, &wfds))
+            if (tgdb_process_writable(tgdb, gdbfd) == -1)
+                return -1;
+
+        if (FD_ISSET(mifd, &wfds))
+            if (tgdb_process_writable(tgdb, mifd) == -1)
+                return -1;
     }
 
     return 0;
 }
 
-void console_output(void *context, const std::string &str) {
-    std::string::const_iterator iter = str.begin();
-    for (; iter != str.end(); ++iter) {
-        if (write(STDOUT_FILENO, &*iter, 1) != 1) {
-            clog_error(CLOG_CGDB, "could not write byte");
-        }
+void console_output(void *context, const char *data, size_t size) {
+    if (replaying)
+        return;
+
+    if (io_writen(STDOUT_FILENO, data, size) == -1) {
+        clog_error(CLOG_CGDB, "could not write console output");
     }
 }
 
@@ -235,9 +268,346 @@ tgdb_callbacks callbacks = {
     command_response
 };
 
+/* Session replay {{{ */
+
+/* A record of a session file, see tgdb_record_session */
+struct session_record {
+    uint64_t time;
+    char stream;
+    std::string data;
+};
+
+static uint64_t time_usec(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Read every record of a session file.
+ *
+ * @return
+ * 0 on success or -1 if the file could not be read.
+ */
+static int read_session(const char *path,
+        std::vector<struct session_record> &records)
+{
+    char header[sizeof(TGDB_SESSION_HEADER) + 1];
+    unsigned long size;
+    FILE *file;
+    struct session_record record;
+
+    file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "could not open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    if (!fgets(header, sizeof(header), file) ||
+            strcmp(header, TGDB_SESSION_HEADER "\n") != 0) {
+        fprintf(stderr, "%s is not a tgdb session\n", path);
+        fclose(file);
+        return -1;
+    }
+
+    while (fscanf(file, "%" SCNu64 " %c %lu", &record.time, &record.stream,
+            &size) == 3 && fgetc(file) == '\n') {
+        record.data.resize(size);
+        if ((size && fread(&record.data[0], 1, size, file) != size) ||
+                fgetc(file) != '\n') {
+            fprintf(stderr, "%s is truncated\n", path);
+            break;
+        }
+        records.push_back(record);
+    }
+
+    fclose(file);
+    return 0;
+}
+
+/**
+ * Collect what tgdb has written to one of gdb's descriptors so far.
+ */
+static void replay_drain(int fd, std::string &input)
+{
+    char buf[MAXLINE];
+    ssize_t size;
+
+    while ((size = read(fd, buf, MAXLINE)) > 0)
+        input.append(buf, size);
+}
+
+/**
+ * Let tgdb process everything that is waiting on its side of the
+ * connection, then collect what tgdb wrote to gdb.
+ *
+ * What gdb's side collects makes room for tgdb to write the data it
+ * had to queue, so the two alternate until neither has anything left.
+ */
+static void replay_pump(int console_fd, int mi_fd,
+        int gdb_console_fd, int gdb_mi_fd,
+        std::string &console_input, std::string &mi_input)
+{
+    struct pollfd fds[2];
+    int i;
+
+    fds[0].fd = console_fd;
+    fds[1].fd = mi_fd;
+
+    do {
+        replay_drain(gdb_console_fd, console_input);
+        replay_drain(gdb_mi_fd, mi_input);
+
+        for (i = 0; i < 2; ++i) {
+            fds[i].events = POLLIN;
+            if (tgdb_pending_write_size(tgdb, fds[i].fd) > 0)
+                fds[i].events |= POLLOUT;
+        }
+
+        if (poll(fds, 2, 0) <= 0)
+            break;
+
+        for (i = 0; i < 2 && !gdb_quit; ++i) {
+            if (fds[i].revents & POLLIN)
+                tgdb_process(tgdb, fds[i].fd);
+            if (fds[i].revents & POLLOUT)
+                tgdb_process_writable(tgdb, fds[i].fd);
+        }
+    } while (!gdb_quit);
+
+    replay_drain(gdb_console_fd, console_input);
+    replay_drain(gdb_mi_fd, mi_input);
+}
+
+/**
+ * Send gdb output to tgdb, processing it as it goes.
+ */
+static void replay_output(int fd, const std::string &data,
+        int console_fd, int mi_fd, int gdb_console_fd, int gdb_mi_fd,
+        std::string &console_input, std::string &mi_input)
+{
+    size_t written = 0;
+
+    while (written < data.size() && !gdb_quit) {
+        ssize_t size = write(fd, data.data() + written, data.size() - written);
+        if (size > 0)
+            written += size;
+        else if (size == -1 && errno != EAGAIN && errno != EINTR)
+            break;
+
+        replay_pump(console_fd, mi_fd, gdb_console_fd, gdb_mi_fd,
+                console_input, mi_input);
+    }
+}
+
+/**
+ * Make the front end call recorded in a session.
+ */
+static void replay_request(const std::string &request)
+{
+    char name[64];
+    int line, n, i;
+    unsigned int c;
+    uint64_t addr;
+
+    if (sscanf(request.c_str(), "%63s", name) != 1)
+        return;
+
+    if (strcmp(name, "inferiors_source_files") == 0) {
+        tgdb_request_inferiors_source_files(tgdb);
+    } else if (strcmp(name, "current_location") == 0) {
+        tgdb_request_current_location(tgdb);
+    } else if (strcmp(name, "breakpoints") == 0) {
+        tgdb_request_breakpoints(tgdb);
+    } else if (strcmp(name, "run_debugger_command") == 0 &&
+            sscanf(request.c_str(), "%*s %d", &i) == 1) {
+        tgdb_request_run_debugger_command(tgdb, (enum tgdb_command_type)i);
+    } else if (strcmp(name, "modify_breakpoint") == 0 &&
+            sscanf(request.c_str(), "%*s %d %" SCNx64 " %d %n",
+                &line, &addr, &i, &n) == 3) {
+        const char *file = request.c_str() + n;
+        tgdb_request_modify_breakpoint(tgdb, *file ? file : NULL, line, addr,
+                (enum tgdb_breakpoint_action)i);
+    } else if (strcmp(name, "disassemble_pc") == 0 &&
+            sscanf(request.c_str(), "%*s %" SCNx64 " %d", &addr, &i) == 2) {
+        tgdb_request_disassemble_pc(tgdb, addr, i);
+    } else if (strcmp(name, "disassemble_func") == 0 &&
+            sscanf(request.c_str(), "%*s %" SCNx64 " %d", &addr, &i) == 2) {
+        tgdb_request_disassemble_func(tgdb, addr,
+                (enum disassemble_func_type)i);
+    } else if (strcmp(name, "send_char") == 0 &&
+            sscanf(request.c_str(), "%*s %x", &c) == 1) {
+        tgdb_send_char(tgdb, (char)c);
+    } else if (strcmp(name, "signal_notification") == 0 &&
+            sscanf(request.c_str(), "%*s %d", &i) == 1) {
+        tgdb_signal_notification(tgdb, i);
+    } else {
+        fprintf(stderr, "unknown request in session: %s\n", request.c_str());
+    }
+}
+
+/**
+ * Compare what tgdb wrote to gdb during the replay with the recording.
+ *
+ * @return
+ * 0 if they are the same, -1 otherwise.
+ */
+static int replay_compare(const char *name, const std::string &expected,
+        const std::string &actual)
+{
+    size_t i;
+
+    for (i = 0; i < expected.size() && i < actual.size(); ++i) {
+        if (expected[i] != actual[i])
+            break;
+    }
+
+    if (i == expected.size() && i == actual.size()) {
+        fprintf(stderr, "%s input: matches the recording\n", name);
+        return 0;
+    }
+
+    fprintf(stderr, "%s input: differs from the recording at byte %lu\n",
+            name, (unsigned long)i);
+    return -1;
+}
+
+/**
+ * Replay a recorded session through tgdb.
+ *
+ * The driver stands in for gdb. It sends tgdb the recorded gdb output
+ * and makes the recorded front end calls, in the order they happened.
+ * Each piece of output is fully processed by tgdb before the next one is
+ * sent, so a replay behaves the same every time it is run.
+ *
+ * @param path
+ * The session file, written by tgdb_record_session
+ *
+ * @param fast
+ * If true, replay as fast as possible. Otherwise, wait between records
+ * as long as was waited during the recording.
+ *
+ * @return
+ * 0 if tgdb wrote the same commands to gdb as in the recording,
+ * -1 otherwise.
+ */
+static int replay_session(const char *path, bool fast)
+{
+    std::vector<struct session_record> records;
+    std::string console_expected, mi_expected;
+    std::string console_input, mi_input;
+    int console_pair[2], mi_pair[2];
+    uint64_t start;
+    size_t i;
+    int result = 0;
+
+    if (read_session(path, records) == -1)
+        return -1;
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, console_pair) == -1 ||
+            socketpair(AF_UNIX, SOCK_STREAM, 0, mi_pair) == -1) {
+        fprintf(stderr, "socketpair failed: %s\n", strerror(errno));
+        return -1;
+    }
+
+    /* The driver's ends, which stand in for gdb */
+    fcntl(console_pair[1], F_SETFL, O_NONBLOCK);
+    fcntl(mi_pair[1], F_SETFL, O_NONBLOCK);
+
+    tgdb_connect_gdb(tgdb, console_pair[0], mi_pair[0]);
+
+    start = time_usec();
+
+    for (i = 0; i < records.size() && !gdb_quit; ++i) {
+        const struct session_record &record = records[i];
+
+        if (!fast && (record.stream == 'c' || record.stream == 'm' ||
+                record.stream == 'R')) {
+            uint64_t now = time_usec();
+            if (start + record.time > now)
+                usleep(start + record.time - now);
+        }
+
+        switch (record.stream) {
+            case 'c':
+                replay_output(console_pair[1], record.data,
+                        console_pair[0], mi_pair[0],
+                        console_pair[1], mi_pair[1],
+                        console_input, mi_input);
+                break;
+            case 'm':
+                replay_output(mi_pair[1], record.data,
+                        console_pair[0], mi_pair[0],
+                        console_pair[1], mi_pair[1],
+                        console_input, mi_input);
+                break;
+            case 'C':
+                console_expected += record.data;
+                break;
+            case 'M':
+                mi_expected += record.data;
+                break;
+            case 'R':
+                replay_request(record.data);
+                replay_pump(console_pair[0], mi_pair[0],
+                        console_pair[1], mi_pair[1],
+                        console_input, mi_input);
+                break;
+        }
+    }
+
+    fprintf(stderr, "replayed %lu records in %.3f ms\n",
+            (unsigned long)i, (time_usec() - start) / 1000.0);
+
+    if (replay_compare("console", console_expected, console_input) == -1)
+        result = -1;
+    if (replay_compare("mi", mi_expected, mi_input) == -1)
+        result = -1;
+
+    fprintf(stderr, "%s", tgdb_get_request_stats(tgdb).c_str());
+
+    return result;
+}
+
+/* }}} */
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "Usage:\n"
+            "   tgdb_driver [--record FILE] [gdb options]\n"
+            "   tgdb_driver --replay FILE [--fast]\n"
+            "\n"
+            "   --record FILE  Record the session with gdb to FILE.\n"
+            "   --replay FILE  Replay the session in FILE without gdb.\n"
+            "                  Exits with 1 if tgdb no longer sends gdb the\n"
+            "                  same commands as during the recording.\n"
+            "   --fast         Replay as fast as possible, rather than at\n"
+            "                  the recorded pace.\n");
+}
+
 int main(int argc, char **argv)
 {
     int gdb_console_fd, gdb_mi_fd;
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+    bool fast = false;
+    int result = 0;
+
+    if (argc > 2 && strcmp(argv[1], "--record") == 0) {
+        record_path = argv[2];
+        argc -= 2;
+        argv += 2;
+    } else if (argc > 2 && strcmp(argv[1], "--replay") == 0) {
+        replay_path = argv[2];
+        fast = argc > 3 && strcmp(argv[3], "--fast") == 0;
+        replaying = 1;
+    } else if (argc > 1 && (strcmp(argv[1], "--record") == 0 ||
+            strcmp(argv[1], "--replay") == 0 ||
+            strcmp(argv[1], "--help") == 0)) {
+        usage();
+        return 1;
+    }
 
 #if 0
     int c;
@@ -252,6 +622,21 @@ int main(int argc, char **argv)
     clog_set_level(CLOG_GDBIO_ID, CLOG_DEBUG);
     clog_set_level(CLOG_GDBMIIO_ID, CLOG_DEBUG);
 
+    if (replay_path) {
+        if ((tgdb = tgdb_initialize(callbacks)) == NULL) {
+            clog_error(CLOG_CGDB, "tgdb_start error");
+            tgdb_close_logfiles();
+            return 1;
+        }
+
+        if (replay_session(replay_path, fast) == -1)
+            result = 1;
+
+        tgdb_shutdown(tgdb);
+        tgdb_close_logfiles();
+        return result;
+    }
+
     if (tty_cbreak(STDIN_FILENO, &term_attributes) == -1)
         clog_error(CLOG_CGDB, "tty_cbreak error");
 
@@ -260,6 +645,11 @@ int main(int argc, char **argv)
         goto driver_end;
     }
 
+    if (record_path && tgdb_record_session(tgdb, record_path) == -1) {
+        fprintf(stderr, "could not record to %s\n", record_path);
+        goto driver_end;
+    }
+
     if (tgdb_start_gdb(tgdb, NULL, argc - 1, argv + 1, 0, 0,
             &gdb_console_fd, &gdb_mi_fd ) == -1) {
         clog_error(CLOG_CGDB, "tgdb_start error");
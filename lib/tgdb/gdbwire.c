@@ -656,6 +656,9 @@ gdbwire_logger_log(const char *file, int line, enum gdbwire_logger_level level,
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /* #include "gdbwire_sys.h" */
 /***** Include gdbwire_assert.h in the middle of gdbwire_mi_parser.c *********/
@@ -989,12 +992,21 @@ struct gdbwire_mi_output {
      * MI output from GDB. This field represents the line that created 
      * this particular output structure.
      *
-     * This field is always available and never NULL, even for a parse error.
+     * Copying every line is wasted work for most front ends, so this
+     * field is only set for prompts and parse errors, unless the parser
+     * was asked to keep every line with gdbwire_mi_parser_keep_lines.
+     * Otherwise it is NULL.
      */
     char *line;
 
     /** The next GDB/MI output command or NULL if none */
     struct gdbwire_mi_output *next;
+
+    /**
+     * The memory this output and everything it refers to was allocated
+     * from. It is released by gdbwire_mi_output_free.
+     */
+    struct gdbwire_mi_arena *arena;
 };
 
 /**
@@ -1668,6 +1680,134 @@ enum gdbwire_result gdbwire_mi_parser_push(struct gdbwire_mi_parser *parser,
 enum gdbwire_result gdbwire_mi_parser_push_data(
         struct gdbwire_mi_parser *parser, const char *data, size_t size);
 
+/**
+ * Choose whether every output command keeps the line it was parsed from.
+ *
+ * By default only prompts and parse errors set gdbwire_mi_output::line.
+ *
+ * @param parser
+ * The gdbwire_mi parser context to operate on.
+ *
+ * @param keep
+ * Non-zero to set gdbwire_mi_output::line for every output command.
+ */
+void gdbwire_mi_parser_keep_lines(struct gdbwire_mi_parser *parser, int keep);
+
+/**
+ * Choose whether lines are parsed by the hand written parser first.
+ *
+ * The hand written parser is faster and produces the same output
+ * commands as the grammar, which parses any line it does not accept.
+ * It is used by default.
+ *
+ * @param parser
+ * The gdbwire_mi parser context to operate on.
+ *
+ * @param use
+ * Non-zero to use the hand written parser, zero for only the grammar.
+ */
+void gdbwire_mi_parser_use_fast_path(struct gdbwire_mi_parser *parser,
+        int use);
+
+/**
+ * Hand the elements of a list to a callback as they are parsed.
+ *
+ * Some result records hold lists with thousands of elements, like the
+ * files of -file-list-exec-source-files or the body of the -break-info
+ * table. Streaming such a list lets the front end convert each element
+ * while the parser reuses the memory of the one before, instead of
+ * building the whole list first.
+ *
+ * A line is only parsed once its newline arrives, so the elements are
+ * handed over after the whole line has been read and the raw line is
+ * held in memory in full. What streaming saves is the parsed copies:
+ * only one element of the list is kept as parsed results at a time.
+ *
+ * The elements of a streamed list are handed over before the result
+ * record holding the list is delivered, and the list is left empty in
+ * the record. If the line turns out not to be valid GDB/MI, some of its
+ * elements may have been handed over without a result record following.
+ *
+ * @param parser
+ * The gdbwire_mi parser context to operate on.
+ *
+ * @param path
+ * The variables leading to the list from the result record, separated
+ * by periods. For example, "files" or "BreakpointTable.body".
+ *
+ * @param callback
+ * Called with each element of the list. The token is the token of the
+ * result record, or NULL if it has none. The element is freed when the
+ * callback returns.
+ *
+ * @param context
+ * Passed to the callback.
+ *
+ * @return
+ * GDBWIRE_OK on success or GDBWIRE_NOMEM if out of memory.
+ */
+enum gdbwire_result gdbwire_mi_parser_stream_list(
+        struct gdbwire_mi_parser *parser, const char *path,
+        void (*callback)(void *context, const char *token,
+            struct gdbwire_mi_result *element),
+        void *context);
+
+/**
+ * How much of a record the parser builds.
+ *
+ * Front ends usually act on only a few kinds of records. Records they
+ * are not interested in are recognized by their prefix and class, and
+ * skipped or delivered without being parsed.
+ */
+enum gdbwire_mi_interest {
+    /* Parse the record fully, the default for every record */
+    GDBWIRE_MI_INTEREST_FULL,
+
+    /**
+     * Only deliver what kind of record it is.
+     *
+     * An async record has its token, kind and class but no results.
+     * A stream record has its kind but a NULL cstring.
+     */
+    GDBWIRE_MI_INTEREST_CLASS,
+
+    /* Skip the record, no output command is created for it */
+    GDBWIRE_MI_INTEREST_NONE
+};
+
+/**
+ * Set how much of the async records of a class the parser builds.
+ *
+ * @param parser
+ * The gdbwire_mi parser context to operate on.
+ *
+ * @param async_class
+ * The async class, GDBWIRE_MI_ASYNC_UNSUPPORTED for every class
+ * gdbwire does not know.
+ *
+ * @param interest
+ * How much of the records to build.
+ */
+void gdbwire_mi_parser_set_async_interest(struct gdbwire_mi_parser *parser,
+        enum gdbwire_mi_async_class async_class,
+        enum gdbwire_mi_interest interest);
+
+/**
+ * Set how much of the stream records of a kind the parser builds.
+ *
+ * @param parser
+ * The gdbwire_mi parser context to operate on.
+ *
+ * @param kind
+ * The kind of stream record.
+ *
+ * @param interest
+ * How much of the records to build.
+ */
+void gdbwire_mi_parser_set_stream_interest(struct gdbwire_mi_parser *parser,
+        enum gdbwire_mi_stream_record_kind kind,
+        enum gdbwire_mi_interest interest);
+
 #ifdef __cplusplus 
 }
 #endif 
@@ -1676,6 +1816,171 @@ enum gdbwire_result gdbwire_mi_parser_push_data(
 /***** End of gdbwire_mi_parser.h ********************************************/
 /***** Continuing where we left off in gdbwire_mi_parser.c *******************/
 /* #include "gdbwire_string.h" */
+/***** Include gdbwire_mi_pt_alloc.h in the middle of gdbwire_mi_parser.c ****/
+/***** Begin file gdbwire_mi_pt_alloc.h **************************************/
+#ifndef GDBWIRE_MI_PT_ALLOC_H
+#define GDBWIRE_MI_PT_ALLOC_H
+
+#ifdef __cplusplus 
+extern "C" { 
+#endif 
+
+/**
+ * Responsible for allocating and deallocating gdbwire_mi_pt objects.
+ *
+ * Every object in the parse tree of a GDB/MI line, including its strings,
+ * is allocated from one arena. The arena is handed to the
+ * gdbwire_mi_output created for the line, and gdbwire_mi_output_free
+ * releases the whole tree at once.
+ */
+
+/* The memory the parse tree of a GDB/MI line is allocated from */
+struct gdbwire_mi_arena;
+
+/**
+ * Create an arena.
+ *
+ * @param size
+ * The number of bytes the arena is expected to hold. The arena grows
+ * past this if needed.
+ *
+ * @return
+ * The new arena or NULL if out of memory.
+ */
+struct gdbwire_mi_arena *gdbwire_mi_arena_create(size_t size);
+
+/**
+ * Free an arena and everything allocated from it.
+ *
+ * @param arena
+ * The arena to free, may be NULL.
+ */
+void gdbwire_mi_arena_destroy(struct gdbwire_mi_arena *arena);
+
+/* A block of memory an arena hands out allocations from */
+struct gdbwire_mi_arena_block;
+
+/**
+ * A point in an arena's allocations.
+ *
+ * Releasing an arena back to a mark frees everything allocated since,
+ * so a parser can reuse the memory of a subtree it is done with.
+ */
+struct gdbwire_mi_arena_mark {
+    /* The arena's newest block when the mark was made */
+    struct gdbwire_mi_arena_block *block;
+    /* The number of bytes of that block handed out at the time */
+    size_t used;
+};
+
+/**
+ * Remember the current point in an arena's allocations.
+ *
+ * @param arena
+ * The arena to mark.
+ *
+ * @param mark
+ * Set to the current point.
+ */
+void gdbwire_mi_arena_mark(struct gdbwire_mi_arena *arena,
+        struct gdbwire_mi_arena_mark *mark);
+
+/**
+ * Free everything allocated from an arena since a mark.
+ *
+ * @param arena
+ * The arena to release memory from.
+ *
+ * @param mark
+ * A mark made on the arena, with no release to an earlier mark since.
+ */
+void gdbwire_mi_arena_release(struct gdbwire_mi_arena *arena,
+        const struct gdbwire_mi_arena_mark *mark);
+
+/**
+ * Allocate zeroed memory from an arena.
+ *
+ * @param arena
+ * The arena to allocate from.
+ *
+ * @param size
+ * The number of bytes to allocate.
+ *
+ * @return
+ * The memory, suitably aligned for any parse tree object,
+ * or NULL if out of memory.
+ */
+void *gdbwire_mi_arena_alloc(struct gdbwire_mi_arena *arena, size_t size);
+
+/**
+ * Copy data into an arena as a null terminated string.
+ *
+ * @param arena
+ * The arena to allocate from.
+ *
+ * @param str
+ * The data to copy, it does not need to be null terminated.
+ *
+ * @param size
+ * The number of bytes to copy.
+ *
+ * @return
+ * The string or NULL if out of memory.
+ */
+char *gdbwire_mi_arena_strndup(struct gdbwire_mi_arena *arena,
+        const char *str, size_t size);
+
+/**
+ * Copy a GDB/MI c-string into an arena with its escaping undone.
+ *
+ * @param arena
+ * The arena to allocate from.
+ *
+ * @param str
+ * The c-string as GDB sent it, including the surrounding quotes.
+ * It does not need to be null terminated.
+ *
+ * @param length
+ * The number of bytes in str, at least 2.
+ *
+ * @return
+ * The unescaped string or NULL if out of memory.
+ */
+char *gdbwire_mi_arena_unescape(struct gdbwire_mi_arena *arena,
+        const char *str, size_t length);
+
+/* struct gdbwire_mi_output */
+struct gdbwire_mi_output *gdbwire_mi_output_alloc(
+        struct gdbwire_mi_arena *arena);
+void gdbwire_mi_output_free(struct gdbwire_mi_output *param);
+
+/* struct gdbwire_mi_result_record */
+struct gdbwire_mi_result_record *gdbwire_mi_result_record_alloc(
+        struct gdbwire_mi_arena *arena);
+
+/* struct gdbwire_mi_result */
+struct gdbwire_mi_result *gdbwire_mi_result_alloc(
+        struct gdbwire_mi_arena *arena);
+
+/* struct gdbwire_mi_oob_record */
+struct gdbwire_mi_oob_record *gdbwire_mi_oob_record_alloc(
+        struct gdbwire_mi_arena *arena);
+
+/* struct gdbwire_mi_async_record */
+struct gdbwire_mi_async_record *gdbwire_mi_async_record_alloc(
+        struct gdbwire_mi_arena *arena);
+
+/* struct gdbwire_mi_stream_record */
+struct gdbwire_mi_stream_record *gdbwire_mi_stream_record_alloc(
+        struct gdbwire_mi_arena *arena);
+
+#ifdef __cplusplus 
+}
+#endif 
+
+#endif /* GDBWIRE_MI_PT_ALLOC_H */
+/***** End of gdbwire_mi_pt_alloc.h ******************************************/
+/***** Continuing where we left off in gdbwire_mi_parser.c *******************/
 
 /* flex prototypes used in this unit */
 #ifndef YY_TYPEDEF_YY_SCANNER_T
@@ -1689,8 +1994,8 @@ typedef struct yy_buffer_state *YY_BUFFER_STATE;
 #endif
 
 /* Lexer set/destroy buffer to parse */
-extern YY_BUFFER_STATE gdbwire_mi__scan_string(
-    const char *yy_str, yyscan_t yyscanner);
+extern YY_BUFFER_STATE gdbwire_mi__scan_buffer(
+    char *base, size_t size, yyscan_t yyscanner);
 extern void gdbwire_mi__delete_buffer(YY_BUFFER_STATE state,
     yyscan_t yyscanner);
 
@@ -1699,10 +2004,107 @@ extern int gdbwire_mi_lex(yyscan_t yyscanner);
 extern char *gdbwire_mi_get_text(yyscan_t yyscanner);
 extern void gdbwire_mi_set_column(int column_no, yyscan_t yyscanner);
 
+/**
+ * The lexer's extra data.
+ *
+ * The grammar reads it back with gdbwire_mi_get_extra to find the
+ * position of the current token and where to allocate the parse tree.
+ */
+struct gdbwire_mi_lexer_extra {
+    /* The position of the last token the lexer matched */
+    struct gdbwire_mi_position pos;
+    /* The arena the parse tree of the current line is allocated from */
+    struct gdbwire_mi_arena *arena;
+};
+
+extern void gdbwire_mi_set_extra(struct gdbwire_mi_lexer_extra extra,
+    yyscan_t yyscanner);
+
 /* Lexer state create/destroy functions */
 extern int gdbwire_mi_lex_init(yyscan_t *scanner);
 extern int gdbwire_mi_lex_destroy(yyscan_t scanner);
 
+/* The longest path of a streamed list */
+#define GDBWIRE_MI_LIST_STREAM_PATH_MAX 256
+
+/**
+ * A list whose elements are handed to a callback as they are parsed.
+ *
+ * See gdbwire_mi_parser_stream_list.
+ */
+struct gdbwire_mi_list_stream {
+    /* The variables leading to the list, separated by periods */
+    char *path;
+    /* The number of characters in path */
+    size_t path_size;
+    /* The callback to hand each element to */
+    void (*callback)(void *context, const char *token,
+        struct gdbwire_mi_result *element);
+    /* Passed to the callback */
+    void *context;
+    /* The number of elements of the current line handed over so far */
+    size_t streamed;
+    /* The next streamed list or NULL */
+    struct gdbwire_mi_list_stream *next;
+};
+
+/**
+ * Append a variable to the path of the result being parsed.
+ *
+ * A path too long for the buffer keeps growing in size but not in
+ * content, so it never matches a streamed list.
+ *
+ * @param path
+ * A buffer of GDBWIRE_MI_LIST_STREAM_PATH_MAX characters.
+ *
+ * @param path_size
+ * The number of characters in the path.
+ *
+ * @param name
+ * The variable to append.
+ *
+ * @param size
+ * The number of characters in name.
+ *
+ * @return
+ * The new number of characters in the path.
+ */
+static size_t
+gdbwire_mi_list_stream_path(char *path, size_t path_size,
+    const char *name, size_t size)
+{
+    size_t new_size = path_size + (path_size > 0) + size;
+
+    if (new_size < GDBWIRE_MI_LIST_STREAM_PATH_MAX) {
+        if (path_size > 0) {
+            path[path_size] = '.';
+        }
+        memcpy(path + new_size - size, name, size);
+    }
+
+    return new_size;
+}
+
+/**
+ * Find the streamed list at a path.
+ *
+ * @return
+ * The streamed list or NULL if the list at path is not streamed.
+ */
+static struct gdbwire_mi_list_stream *
+gdbwire_mi_list_stream_find(struct gdbwire_mi_list_stream *streams,
+    const char *path, size_t path_size)
+{
+    for (; streams; streams = streams->next) {
+        if (streams->path_size == path_size &&
+                memcmp(streams->path, path, path_size) == 0) {
+            return streams;
+        }
+    }
+
+    return NULL;
+}
+
 struct gdbwire_mi_parser {
     /* The buffer pushed into the parser from the user */
     struct gdbwire_string *buffer;
@@ -1712,6 +2114,18 @@ struct gdbwire_mi_parser {
     gdbwire_mi_pstate *mipst;
     /* The client parser callbacks */
     struct gdbwire_mi_parser_callbacks callbacks;
+    /* Non-zero to copy every line into gdbwire_mi_output::line */
+    int keep_lines;
+    /* Non-zero to try the hand written parser before the grammar */
+    int fast_path;
+    /* How much of each kind of async record to parse */
+    unsigned char async_interest[GDBWIRE_MI_ASYNC_UNSUPPORTED + 1];
+    /* How much of each kind of stream record to parse */
+    unsigned char stream_interest[GDBWIRE_MI_LOG + 1];
+    /* Non-zero once any record is not fully parsed */
+    int filtering;
+    /* The lists to hand to callbacks element by element, or NULL */
+    struct gdbwire_mi_list_stream *streams;
 };
 
 struct gdbwire_mi_parser *
@@ -1758,6 +2172,7 @@ gdbwire_mi_parser_create(struct gdbwire_mi_parser_callbacks callbacks)
     }
 
     parser->callbacks = callbacks;
+    parser->fast_path = 1;
 
     return parser;
 }
@@ -1783,6 +2198,13 @@ void gdbwire_mi_parser_destroy(struct gdbwire_mi_parser *parser)
             parser->mipst = NULL;
         }
 
+        while (parser->streams) {
+            struct gdbwire_mi_list_stream *next = parser->streams->next;
+            free(parser->streams->path);
+            free(parser->streams);
+            parser->streams = next;
+        }
+
         free(parser);
         parser = NULL;
     }
@@ -1794,153 +2216,1141 @@ gdbwire_mi_parser_get_callbacks(struct gdbwire_mi_parser *parser)
     return parser->callbacks;
 }
 
-/**
- * Parse a single line of output in GDB/MI format.
- *
- * The normal usage of this function is to call it over and over again with
- * more data lines and wait for it to return an mi output command.
- *
- * @param parser
- * The parser context to operate on.
- *
- * @param line
- * A line of output in GDB/MI format to be parsed.
- *
- * \return
- * GDBWIRE_OK on success or appropriate error result on failure.
- */
-static enum gdbwire_result
-gdbwire_mi_parser_parse_line(struct gdbwire_mi_parser *parser,
-    const char *line)
+void gdbwire_mi_parser_keep_lines(struct gdbwire_mi_parser *parser, int keep)
 {
-    struct gdbwire_mi_parser_callbacks callbacks =
-        gdbwire_mi_parser_get_callbacks(parser);
-    struct gdbwire_mi_output *output = 0;
-    YY_BUFFER_STATE state = 0;
-    int pattern, mi_status;
-
-    GDBWIRE_ASSERT(parser && line);
-
-    /* Create a new input buffer for flex. */
-    state = gdbwire_mi__scan_string(line, parser->mils);
-    GDBWIRE_ASSERT(state);
-    gdbwire_mi_set_column(1, parser->mils);
+    if (parser) {
+        parser->keep_lines = keep;
+    }
+}
 
-    /* Iterate over all the tokens found in the scanner buffer */
-    do {
-        pattern = gdbwire_mi_lex(parser->mils);
-        if (pattern == 0)
-            break;
-        mi_status = gdbwire_mi_push_parse(parser->mipst, pattern, NULL,
-            parser->mils, &output);
-    } while (mi_status == YYPUSH_MORE);
+void gdbwire_mi_parser_use_fast_path(struct gdbwire_mi_parser *parser,
+    int use)
+{
+    if (parser) {
+        parser->fast_path = use;
+    }
+}
 
-    /* Free the scanners buffer */
-    gdbwire_mi__delete_buffer(state, parser->mils);
+enum gdbwire_result
+gdbwire_mi_parser_stream_list(struct gdbwire_mi_parser *parser,
+    const char *path,
+    void (*callback)(void *context, const char *token,
+        struct gdbwire_mi_result *element),
+    void *context)
+{
+    struct gdbwire_mi_list_stream *stream;
 
-    /**
-     * The push parser will return,
-     * - 0 if parsing was successful (return is due to end-of-input).
-     * - 1 if parsing failed because of invalid input, i.e., input
-     *     that contains a syntax error or that causes YYABORT to be invoked.
-     * - 2 if parsing failed due to memory exhaustion. 
-     * - YYPUSH_MORE if more input is required to finish parsing the grammar. 
-     * Anything besides this would be unexpected.
-     *
-     * The grammar is designed to accept an infinate list of GDB/MI
-     * output commands. For this reason, YYPUSH_MORE is the expected
-     * return value of all the calls to gdbwire_mi_push_parse. However,
-     * in reality, gdbwire only translates a line at a time from GDB.
-     * When the line is finished, gdbwire_mi_lex returns 0, and the parsing
-     * is done.
-     */
+    GDBWIRE_ASSERT(parser && path && callback);
+    GDBWIRE_ASSERT(strlen(path) < GDBWIRE_MI_LIST_STREAM_PATH_MAX);
 
-    /* Check mi_status, will be 1 on parse error, and YYPUSH_MORE on success */
-    GDBWIRE_ASSERT(mi_status == 1 || mi_status == YYPUSH_MORE);
+    stream = calloc(1, sizeof(struct gdbwire_mi_list_stream));
+    if (!stream) {
+        return GDBWIRE_NOMEM;
+    }
 
-    /* Each GDB/MI line should produce an output command */
-    GDBWIRE_ASSERT(output);
-    output->line = gdbwire_strdup(line);
+    stream->path = gdbwire_strdup(path);
+    if (!stream->path) {
+        free(stream);
+        return GDBWIRE_NOMEM;
+    }
 
-    callbacks.gdbwire_mi_output_callback(callbacks.context, output);
+    stream->path_size = strlen(path);
+    stream->callback = callback;
+    stream->context = context;
+    stream->next = parser->streams;
+    parser->streams = stream;
 
     return GDBWIRE_OK;
 }
 
+void gdbwire_mi_parser_set_async_interest(struct gdbwire_mi_parser *parser,
+    enum gdbwire_mi_async_class async_class,
+    enum gdbwire_mi_interest interest)
+{
+    if (parser && async_class <= GDBWIRE_MI_ASYNC_UNSUPPORTED) {
+        parser->async_interest[async_class] = interest;
+        parser->filtering |= (interest != GDBWIRE_MI_INTEREST_FULL);
+    }
+}
+
+void gdbwire_mi_parser_set_stream_interest(struct gdbwire_mi_parser *parser,
+    enum gdbwire_mi_stream_record_kind kind,
+    enum gdbwire_mi_interest interest)
+{
+    if (parser && kind <= GDBWIRE_MI_LOG) {
+        parser->stream_interest[kind] = interest;
+        parser->filtering |= (interest != GDBWIRE_MI_INTEREST_FULL);
+    }
+}
+
+/**
+ * The hand written GDB/MI parser.
+ *
+ * Lexing with flex and parsing with bison costs a call into the push
+ * parser for every token. The lines GDB sends most often have simple and
+ * predictable shapes, so they are parsed first by the recursive descent
+ * parser below, which builds the same parse tree directly.
+ *
+ * It only accepts lines the grammar accepts. Anything else, including
+ * lines the grammar would report a parse error for, is rejected and
+ * handed to the flex and bison parser, which then produces the output.
+ *
+ * Set GDBWIRE_MI_FAST_PATH to 0 to build without it. It can also be
+ * turned off at run time with gdbwire_mi_parser_use_fast_path.
+ */
+#ifndef GDBWIRE_MI_FAST_PATH
+#define GDBWIRE_MI_FAST_PATH 1
+#endif
+
+/* Deeper tuples and lists are left to the grammar */
+#define GDBWIRE_MI_FAST_PATH_MAX_DEPTH 64
+
+struct gdbwire_mi_fast_parser {
+    /* The next character to parse */
+    const char *cur;
+    /* One past the last character of the line */
+    const char *end;
+    /* The arena the parse tree is allocated from */
+    struct gdbwire_mi_arena *arena;
+    /* The number of tuples and lists being parsed */
+    int depth;
+    /* The lists to stream, or NULL if none or not in a result record */
+    struct gdbwire_mi_list_stream *streams;
+    /* The token of the result record being parsed or NULL */
+    const char *token;
+    /* The variables leading to the result being parsed, if streaming */
+    char path[GDBWIRE_MI_LIST_STREAM_PATH_MAX];
+    /* The number of characters in path */
+    size_t path_size;
+};
+
+static const struct {
+    const char *name;
+    enum gdbwire_mi_result_class result_class;
+} gdbwire_mi_fast_result_classes[] = {
+    { "done", GDBWIRE_MI_DONE },
+    { "running", GDBWIRE_MI_RUNNING },
+    { "connected", GDBWIRE_MI_CONNECTED },
+    { "error", GDBWIRE_MI_ERROR },
+    { "exit", GDBWIRE_MI_EXIT }
+};
+
+static const struct {
+    const char *name;
+    enum gdbwire_mi_async_class async_class;
+} gdbwire_mi_fast_async_classes[] = {
+    { "download", GDBWIRE_MI_ASYNC_DOWNLOAD },
+    { "stopped", GDBWIRE_MI_ASYNC_STOPPED },
+    { "running", GDBWIRE_MI_ASYNC_RUNNING },
+    { "thread-group-added", GDBWIRE_MI_ASYNC_THREAD_GROUP_ADDED },
+    { "thread-group-removed", GDBWIRE_MI_ASYNC_THREAD_GROUP_REMOVED },
+    { "thread-group-started", GDBWIRE_MI_ASYNC_THREAD_GROUP_STARTED },
+    { "thread-group-exited", GDBWIRE_MI_ASYNC_THREAD_GROUP_EXITED },
+    { "thread-created", GDBWIRE_MI_ASYNC_THREAD_CREATED },
+    { "thread-exited", GDBWIRE_MI_ASYNC_THREAD_EXITED },
+    { "thread-selected", GDBWIRE_MI_ASYNC_THREAD_SELECTED },
+    { "library-loaded", GDBWIRE_MI_ASYNC_LIBRARY_LOADED },
+    { "library-unloaded", GDBWIRE_MI_ASYNC_LIBRARY_UNLOADED },
+    { "traceframe-changed", GDBWIRE_MI_ASYNC_TRACEFRAME_CHANGED },
+    { "tsv-created", GDBWIRE_MI_ASYNC_TSV_CREATED },
+    { "tsv-modified", GDBWIRE_MI_ASYNC_TSV_MODIFIED },
+    { "tsv-deleted", GDBWIRE_MI_ASYNC_TSV_DELETED },
+    { "breakpoint-created", GDBWIRE_MI_ASYNC_BREAKPOINT_CREATED },
+    { "breakpoint-modified", GDBWIRE_MI_ASYNC_BREAKPOINT_MODIFIED },
+    { "breakpoint-deleted", GDBWIRE_MI_ASYNC_BREAKPOINT_DELETED },
+    { "record-started", GDBWIRE_MI_ASYNC_RECORD_STARTED },
+    { "record-stopped", GDBWIRE_MI_ASYNC_RECORD_STOPPED },
+    { "cmd-param-changed", GDBWIRE_MI_ASYNC_CMD_PARAM_CHANGED },
+    { "memory-changed", GDBWIRE_MI_ASYNC_MEMORY_CHANGED }
+};
+
+#define GDBWIRE_MI_FAST_COUNT(array) (sizeof(array) / sizeof((array)[0]))
+
+/* The lexer's character classes, which do not depend on the locale */
+#define GDBWIRE_MI_FAST_IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+#define GDBWIRE_MI_FAST_IS_NAME_START(c) \
+    (((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z') || (c) == '_')
+#define GDBWIRE_MI_FAST_IS_NAME(c) \
+    (GDBWIRE_MI_FAST_IS_NAME_START(c) || GDBWIRE_MI_FAST_IS_DIGIT(c) || \
+     (c) == '-')
+
+/* Compare a name from the line to a null terminated name */
+static int
+gdbwire_mi_fast_name_is(const char *name, size_t size, const char *cstr)
+{
+    return strncmp(name, cstr, size) == 0 && cstr[size] == '\0';
+}
+
+/* Skip the white space the lexer ignores between tokens */
+static void
+gdbwire_mi_fast_skip_space(struct gdbwire_mi_fast_parser *p)
+{
+    while (p->cur < p->end && (*p->cur == ' ' || *p->cur == '\t' ||
+            *p->cur == '\v' || *p->cur == '\f')) {
+        ++p->cur;
+    }
+}
+
 /**
- * Get the next line available in the buffer.
+ * Parse a name, the lexer's [_A-Za-z][_A-Za-z0-9-]* string literal.
  *
- * @param buffer
- * The entire buffer the user has pushed onto the gdbwire_mi parser
- * through gdbwire_mi_parser_push. If a line is found, the returned line
- * will be removed from this buffer.
+ * @return
+ * The number of characters in the name, 0 if there isn't one.
+ */
+static size_t
+gdbwire_mi_fast_name(struct gdbwire_mi_fast_parser *p)
+{
+    const char *cur = p->cur;
+
+    if (cur == p->end || !GDBWIRE_MI_FAST_IS_NAME_START(*cur)) {
+        return 0;
+    }
+
+    ++cur;
+    while (cur < p->end && GDBWIRE_MI_FAST_IS_NAME(*cur)) {
+        ++cur;
+    }
+
+    return cur - p->cur;
+}
+
+/* Look up the result class named by a result record */
+static enum gdbwire_mi_result_class
+gdbwire_mi_fast_result_class(const char *name, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < GDBWIRE_MI_FAST_COUNT(
+            gdbwire_mi_fast_result_classes); ++i) {
+        if (gdbwire_mi_fast_name_is(name, size,
+                gdbwire_mi_fast_result_classes[i].name)) {
+            return gdbwire_mi_fast_result_classes[i].result_class;
+        }
+    }
+
+    return GDBWIRE_MI_UNSUPPORTED;
+}
+
+/* Look up the async class named by an async record */
+static enum gdbwire_mi_async_class
+gdbwire_mi_fast_async_class(const char *name, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < GDBWIRE_MI_FAST_COUNT(
+            gdbwire_mi_fast_async_classes); ++i) {
+        if (gdbwire_mi_fast_name_is(name, size,
+                gdbwire_mi_fast_async_classes[i].name)) {
+            return gdbwire_mi_fast_async_classes[i].async_class;
+        }
+    }
+
+    return GDBWIRE_MI_ASYNC_UNSUPPORTED;
+}
+
+#if GDBWIRE_MI_FAST_PATH
+
+/**
+ * Find the first quote or backslash in a c-string.
+ *
+ * This is where most of the time parsing a line goes, since the values
+ * GDB sends are nearly all c-strings. With SSE2, 16 characters are
+ * checked at a time.
+ *
+ * @return
+ * The quote or backslash, or end if there isn't one.
+ */
+static const char *
+gdbwire_mi_fast_find_quote(const char *cur, const char *end)
+{
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+
+    for (; end - cur >= 16; cur += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)cur);
+        int mask = _mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+        if (mask) {
+            return cur + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    while (cur < end && *cur != '"' && *cur != '\\') {
+        ++cur;
+    }
+
+    return cur;
+}
+
+/**
+ * Parse a c-string, the lexer's \"(\\.|[^"\\])*\" pattern.
+ *
+ * @return
+ * The unescaped c-string or NULL if there isn't one.
+ */
+static char *
+gdbwire_mi_fast_cstring(struct gdbwire_mi_fast_parser *p)
+{
+    const char *start = p->cur, *cur;
+    int escaped = 0;
+
+    if (start == p->end || *start != '"') {
+        return NULL;
+    }
+
+    for (cur = start + 1;;) {
+        cur = gdbwire_mi_fast_find_quote(cur, p->end);
+        if (cur == p->end) {
+            return NULL;
+        } else if (*cur == '"') {
+            break;
+        }
+
+        /* The lexer does not let a backslash escape a newline */
+        if (cur + 1 == p->end || cur[1] == '\n') {
+            return NULL;
+        }
+        cur += 2;
+        escaped = 1;
+    }
+
+    p->cur = cur + 1;
+
+    /* Most values, like addresses and file names, have nothing to undo */
+    if (!escaped) {
+        return gdbwire_mi_arena_strndup(p->arena, start + 1, cur - start - 1);
+    }
+
+    return gdbwire_mi_arena_unescape(p->arena, start, p->cur - start);
+}
+
+static struct gdbwire_mi_result *
+gdbwire_mi_fast_result_list(struct gdbwire_mi_fast_parser *p);
+
+static struct gdbwire_mi_result *
+gdbwire_mi_fast_result(struct gdbwire_mi_fast_parser *p);
+
+/**
+ * Parse the elements of a streamed list, handing each to its callback.
+ *
+ * The memory of each element is reused for the next one.
+ *
+ * @return
+ * 1 on success or 0 if the line is not one the fast path parses.
+ */
+static int
+gdbwire_mi_fast_stream_list(struct gdbwire_mi_fast_parser *p,
+    struct gdbwire_mi_list_stream *stream)
+{
+    struct gdbwire_mi_arena_mark mark;
+    struct gdbwire_mi_result *element;
+
+    gdbwire_mi_arena_mark(p->arena, &mark);
+
+    for (;;) {
+        element = gdbwire_mi_fast_result(p);
+        if (!element) {
+            return 0;
+        }
+
+        stream->callback(stream->context, p->token, element);
+        ++stream->streamed;
+        gdbwire_mi_arena_release(p->arena, &mark);
+
+        gdbwire_mi_fast_skip_space(p);
+        if (p->cur == p->end || *p->cur != ',') {
+            break;
+        }
+        ++p->cur;
+    }
+
+    return 1;
+}
+
+/**
+ * Parse a tuple or a list, whichever p is at.
+ *
+ * @return
+ * 1 on success or 0 if the line is not one the fast path parses.
+ */
+static int
+gdbwire_mi_fast_tuple_or_list(struct gdbwire_mi_fast_parser *p,
+    struct gdbwire_mi_result *result)
+{
+    char close = (*p->cur == '{') ? '}' : ']';
+    struct gdbwire_mi_list_stream *stream = NULL;
+
+    if (++p->depth > GDBWIRE_MI_FAST_PATH_MAX_DEPTH) {
+        return 0;
+    }
+
+    result->kind = (close == '}') ? GDBWIRE_MI_TUPLE : GDBWIRE_MI_LIST;
+
+    if (p->streams && result->kind == GDBWIRE_MI_LIST) {
+        stream = gdbwire_mi_list_stream_find(p->streams,
+            p->path, p->path_size);
+    }
+
+    ++p->cur;
+    gdbwire_mi_fast_skip_space(p);
+    if (p->cur < p->end && *p->cur != close) {
+        if (stream) {
+            if (!gdbwire_mi_fast_stream_list(p, stream)) {
+                return 0;
+            }
+        } else {
+            result->variant.result = gdbwire_mi_fast_result_list(p);
+            if (!result->variant.result) {
+                return 0;
+            }
+        }
+    }
+
+    gdbwire_mi_fast_skip_space(p);
+    if (p->cur == p->end || *p->cur != close) {
+        return 0;
+    }
+    ++p->cur;
+    --p->depth;
+
+    return 1;
+}
+
+/**
+ * Parse a result, an optional variable and its value.
+ *
+ * @return
+ * The result or NULL if the line is not one the fast path parses.
+ */
+static struct gdbwire_mi_result *
+gdbwire_mi_fast_result(struct gdbwire_mi_fast_parser *p)
+{
+    struct gdbwire_mi_result *result = gdbwire_mi_result_alloc(p->arena);
+    size_t size, path_size = p->path_size;
+
+    if (!result) {
+        return NULL;
+    }
+
+    gdbwire_mi_fast_skip_space(p);
+    size = gdbwire_mi_fast_name(p);
+    if (size > 0) {
+        result->variable = gdbwire_mi_arena_strndup(p->arena, p->cur, size);
+        if (p->streams) {
+            p->path_size = gdbwire_mi_list_stream_path(p->path, path_size,
+                p->cur, size);
+        }
+        p->cur += size;
+        gdbwire_mi_fast_skip_space(p);
+        if (!result->variable || p->cur == p->end || *p->cur != '=') {
+            return NULL;
+        }
+        ++p->cur;
+        gdbwire_mi_fast_skip_space(p);
+    }
+
+    if (p->cur == p->end) {
+        return NULL;
+    } else if (*p->cur == '"') {
+        result->kind = GDBWIRE_MI_CSTRING;
+        result->variant.cstring = gdbwire_mi_fast_cstring(p);
+        if (!result->variant.cstring) {
+            return NULL;
+        }
+    } else if (*p->cur == '{' || *p->cur == '[') {
+        if (!gdbwire_mi_fast_tuple_or_list(p, result)) {
+            return NULL;
+        }
+    } else {
+        return NULL;
+    }
+
+    p->path_size = path_size;
+
+    return result;
+}
+
+/**
+ * Parse a comma separated list of results.
+ *
+ * @return
+ * The first result or NULL if the line is not one the fast path parses.
+ */
+static struct gdbwire_mi_result *
+gdbwire_mi_fast_result_list(struct gdbwire_mi_fast_parser *p)
+{
+    struct gdbwire_mi_result *head = NULL, **tail = &head;
+
+    for (;;) {
+        *tail = gdbwire_mi_fast_result(p);
+        if (!*tail) {
+            return NULL;
+        }
+        tail = &(*tail)->next;
+
+        gdbwire_mi_fast_skip_space(p);
+        if (p->cur == p->end || *p->cur != ',') {
+            break;
+        }
+        ++p->cur;
+    }
+
+    return head;
+}
+
+/**
+ * Parse the optional results following a result or async record's class.
+ *
+ * @return
+ * 1 on success or 0 if the line is not one the fast path parses.
+ */
+static int
+gdbwire_mi_fast_record_results(struct gdbwire_mi_fast_parser *p,
+    struct gdbwire_mi_result **result)
+{
+    gdbwire_mi_fast_skip_space(p);
+    if (p->cur < p->end && *p->cur == ',') {
+        ++p->cur;
+        *result = gdbwire_mi_fast_result_list(p);
+        return *result != NULL;
+    }
+
+    return 1;
+}
+
+/**
+ * Parse a line of GDB/MI output without the grammar.
+ *
+ * @param arena
+ * The arena to allocate the parse tree from.
+ *
+ * @param streams
+ * The lists of a result record to stream or NULL if none.
+ *
+ * @param line
+ * The line to parse, including its newline.
+ *
+ * @param size
+ * The number of bytes in line.
+ *
+ * @return
+ * The output or NULL if the line is not one the fast path parses.
+ * Some of the parse tree may have been allocated from the arena even
+ * if NULL is returned.
+ */
+static struct gdbwire_mi_output *
+gdbwire_mi_fast_parse(struct gdbwire_mi_arena *arena,
+    struct gdbwire_mi_list_stream *streams, const char *line, size_t size)
+{
+    struct gdbwire_mi_fast_parser parser = { line, line + size, arena, 0 };
+    struct gdbwire_mi_fast_parser *p = &parser;
+    struct gdbwire_mi_output *output = gdbwire_mi_output_alloc(arena);
+    const char *token, *newline;
+    size_t token_size, size_class;
+
+    /* The grammar's c-strings stop at a null character, leave those to it */
+    if (!output || memchr(line, '\0', size)) {
+        return NULL;
+    }
+
+    gdbwire_mi_fast_skip_space(p);
+    token = p->cur;
+    while (p->cur < p->end && GDBWIRE_MI_FAST_IS_DIGIT(*p->cur)) {
+        ++p->cur;
+    }
+    token_size = p->cur - token;
+    gdbwire_mi_fast_skip_space(p);
+
+    if (p->cur == p->end) {
+        return NULL;
+    } else if (*p->cur == '^') {
+        struct gdbwire_mi_result_record *record =
+            gdbwire_mi_result_record_alloc(arena);
+        if (!record) {
+            return NULL;
+        }
+
+        ++p->cur;
+        gdbwire_mi_fast_skip_space(p);
+        size_class = gdbwire_mi_fast_name(p);
+        if (size_class == 0) {
+            return NULL;
+        }
+
+        record->result_class =
+            gdbwire_mi_fast_result_class(p->cur, size_class);
+        p->cur += size_class;
+
+        /* Streamed elements are handed over with the record's token */
+        if (token_size > 0) {
+            record->token = gdbwire_mi_arena_strndup(arena, token, token_size);
+            if (!record->token) {
+                return NULL;
+            }
+        }
+
+        p->streams = streams;
+        p->token = record->token;
+        if (!gdbwire_mi_fast_record_results(p, &record->result)) {
+            return NULL;
+        }
+
+        output->kind = GDBWIRE_MI_OUTPUT_RESULT;
+        output->variant.result_record = record;
+    } else if (*p->cur == '*' || *p->cur == '+' || *p->cur == '=') {
+        struct gdbwire_mi_oob_record *oob = gdbwire_mi_oob_record_alloc(arena);
+        struct gdbwire_mi_async_record *record =
+            gdbwire_mi_async_record_alloc(arena);
+        if (!oob || !record) {
+            return NULL;
+        }
+
+        record->kind = (*p->cur == '*') ? GDBWIRE_MI_EXEC :
+            (*p->cur == '+') ? GDBWIRE_MI_STATUS : GDBWIRE_MI_NOTIFY;
+
+        ++p->cur;
+        gdbwire_mi_fast_skip_space(p);
+        size_class = gdbwire_mi_fast_name(p);
+        if (size_class == 0) {
+            return NULL;
+        }
+
+        record->async_class =
+            gdbwire_mi_fast_async_class(p->cur, size_class);
+        p->cur += size_class;
+
+        if (!gdbwire_mi_fast_record_results(p, &record->result)) {
+            return NULL;
+        }
+
+        if (token_size > 0) {
+            record->token = gdbwire_mi_arena_strndup(arena, token, token_size);
+        }
+
+        oob->kind = GDBWIRE_MI_ASYNC;
+        oob->variant.async_record = record;
+        output->kind = GDBWIRE_MI_OUTPUT_OOB;
+        output->variant.oob_record = oob;
+    } else if (token_size > 0) {
+        /* Only result and async records have a token */
+        return NULL;
+    } else if (*p->cur == '~' || *p->cur == '@' || *p->cur == '&') {
+        struct gdbwire_mi_oob_record *oob = gdbwire_mi_oob_record_alloc(arena);
+        struct gdbwire_mi_stream_record *record =
+            gdbwire_mi_stream_record_alloc(arena);
+        if (!oob || !record) {
+            return NULL;
+        }
+
+        record->kind = (*p->cur == '~') ? GDBWIRE_MI_CONSOLE :
+            (*p->cur == '@') ? GDBWIRE_MI_TARGET : GDBWIRE_MI_LOG;
+
+        ++p->cur;
+        gdbwire_mi_fast_skip_space(p);
+        record->cstring = gdbwire_mi_fast_cstring(p);
+        if (!record->cstring) {
+            return NULL;
+        }
+
+        oob->kind = GDBWIRE_MI_STREAM;
+        oob->variant.stream_record = record;
+        output->kind = GDBWIRE_MI_OUTPUT_OOB;
+        output->variant.oob_record = oob;
+    } else if (*p->cur == '(') {
+        ++p->cur;
+        gdbwire_mi_fast_skip_space(p);
+        if (gdbwire_mi_fast_name(p) != 3 || strncmp(p->cur, "gdb", 3) != 0) {
+            return NULL;
+        }
+        p->cur += 3;
+        gdbwire_mi_fast_skip_space(p);
+        if (p->cur == p->end || *p->cur != ')') {
+            return NULL;
+        }
+        ++p->cur;
+
+        output->kind = GDBWIRE_MI_OUTPUT_PROMPT;
+    } else {
+        return NULL;
+    }
+
+    /* The record must be followed by the end of the line */
+    gdbwire_mi_fast_skip_space(p);
+    newline = p->cur;
+    if (p->cur < p->end && *p->cur == '\r') {
+        ++p->cur;
+    }
+    if (p->cur < p->end && *p->cur == '\n') {
+        ++p->cur;
+    }
+    if (p->cur == newline || p->cur != p->end) {
+        return NULL;
+    }
+
+    return output;
+}
+
+#endif
+
+/**
+ * The start of a stream or async record.
+ *
+ * This is enough to tell whether the parser is interested in the record.
+ */
+struct gdbwire_mi_record_prefix {
+    /* The record's token or NULL if it has none */
+    const char *token;
+    /* The number of characters in token */
+    size_t token_size;
+    /* The character the record starts with, one of ~@&*+= */
+    char kind;
+    /* The name of an async record's class */
+    const char *name;
+    /* The number of characters in name */
+    size_t name_size;
+};
+
+/**
+ * Recognize a stream or async record by its prefix.
+ *
+ * The rest of the line is not looked at, so the record may still turn
+ * out to be a parse error.
+ *
+ * @return
+ * 1 if the line starts like a stream or async record or 0 if not.
+ */
+static int
+gdbwire_mi_record_prefix(const char *line, size_t size,
+    struct gdbwire_mi_record_prefix *prefix)
+{
+    struct gdbwire_mi_fast_parser parser = { line, line + size, NULL, 0 };
+    struct gdbwire_mi_fast_parser *p = &parser;
+
+    gdbwire_mi_fast_skip_space(p);
+    prefix->token = p->cur;
+    while (p->cur < p->end && GDBWIRE_MI_FAST_IS_DIGIT(*p->cur)) {
+        ++p->cur;
+    }
+    prefix->token_size = p->cur - prefix->token;
+    if (prefix->token_size == 0) {
+        prefix->token = NULL;
+    }
+
+    gdbwire_mi_fast_skip_space(p);
+    if (p->cur == p->end) {
+        return 0;
+    }
+    prefix->kind = *p->cur++;
+
+    switch (prefix->kind) {
+        case '~':
+        case '@':
+        case '&':
+            /* Stream records do not have a token */
+            return !prefix->token;
+        case '*':
+        case '+':
+        case '=':
+            gdbwire_mi_fast_skip_space(p);
+            prefix->name = p->cur;
+            prefix->name_size = gdbwire_mi_fast_name(p);
+            return prefix->name_size > 0;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Find out how much of a line's record the parser should build.
+ *
+ * @return
+ * The interest in the line's record, GDBWIRE_MI_INTEREST_FULL for
+ * anything besides stream and async records.
+ */
+static enum gdbwire_mi_interest
+gdbwire_mi_parser_interest(struct gdbwire_mi_parser *parser,
+    const char *line, size_t size)
+{
+    struct gdbwire_mi_record_prefix prefix;
+
+    if (!gdbwire_mi_record_prefix(line, size, &prefix)) {
+        return GDBWIRE_MI_INTEREST_FULL;
+    }
+
+    switch (prefix.kind) {
+        case '~':
+            return parser->stream_interest[GDBWIRE_MI_CONSOLE];
+        case '@':
+            return parser->stream_interest[GDBWIRE_MI_TARGET];
+        case '&':
+            return parser->stream_interest[GDBWIRE_MI_LOG];
+        default:
+            return parser->async_interest[gdbwire_mi_fast_async_class(
+                prefix.name, prefix.name_size)];
+    }
+}
+
+/**
+ * Create the output for a record only its class is wanted of.
+ *
+ * See GDBWIRE_MI_INTEREST_CLASS.
+ *
+ * @return
+ * The output or NULL if out of memory.
+ */
+static struct gdbwire_mi_output *
+gdbwire_mi_record_class(struct gdbwire_mi_arena *arena,
+    const char *line, size_t size)
+{
+    struct gdbwire_mi_record_prefix prefix;
+    struct gdbwire_mi_output *output = gdbwire_mi_output_alloc(arena);
+    struct gdbwire_mi_oob_record *oob = gdbwire_mi_oob_record_alloc(arena);
+
+    if (!output || !oob || !gdbwire_mi_record_prefix(line, size, &prefix)) {
+        return NULL;
+    }
+
+    output->kind = GDBWIRE_MI_OUTPUT_OOB;
+    output->variant.oob_record = oob;
+
+    if (prefix.kind == '~' || prefix.kind == '@' || prefix.kind == '&') {
+        struct gdbwire_mi_stream_record *record =
+            gdbwire_mi_stream_record_alloc(arena);
+        if (!record) {
+            return NULL;
+        }
+
+        record->kind = (prefix.kind == '~') ? GDBWIRE_MI_CONSOLE :
+            (prefix.kind == '@') ? GDBWIRE_MI_TARGET : GDBWIRE_MI_LOG;
+
+        oob->kind = GDBWIRE_MI_STREAM;
+        oob->variant.stream_record = record;
+    } else {
+        struct gdbwire_mi_async_record *record =
+            gdbwire_mi_async_record_alloc(arena);
+        if (!record) {
+            return NULL;
+        }
+
+        if (prefix.token) {
+            record->token = gdbwire_mi_arena_strndup(arena,
+                prefix.token, prefix.token_size);
+        }
+        record->kind = (prefix.kind == '*') ? GDBWIRE_MI_EXEC :
+            (prefix.kind == '+') ? GDBWIRE_MI_STATUS : GDBWIRE_MI_NOTIFY;
+        record->async_class =
+            gdbwire_mi_fast_async_class(prefix.name, prefix.name_size);
+
+        oob->kind = GDBWIRE_MI_ASYNC;
+        oob->variant.async_record = record;
+    }
+
+    return output;
+}
+
+/**
+ * Hand the elements of the streamed lists in a parse tree to their
+ * callbacks and leave the lists empty.
+ *
+ * The fast path hands over elements while it parses them. This does the
+ * same for lines the grammar parsed, skipping the elements the fast path
+ * handed over before it gave up on the line.
+ *
+ * @param parser
+ * The parser with the streamed lists.
+ *
+ * @param token
+ * The token of the result record or NULL.
+ *
+ * @param result
+ * The results to look for streamed lists in.
+ *
+ * @param path
+ * A buffer of GDBWIRE_MI_LIST_STREAM_PATH_MAX characters, holding the
+ * variables leading to result.
+ *
+ * @param path_size
+ * The number of characters in path.
+ */
+static void
+gdbwire_mi_parser_stream_results(struct gdbwire_mi_parser *parser,
+    const char *token, struct gdbwire_mi_result *result,
+    char *path, size_t path_size)
+{
+    for (; result; result = result->next) {
+        struct gdbwire_mi_list_stream *stream = NULL;
+        size_t size = path_size;
+
+        if (result->kind == GDBWIRE_MI_CSTRING) {
+            continue;
+        }
+
+        if (result->variable) {
+            size = gdbwire_mi_list_stream_path(path, path_size,
+                result->variable, strlen(result->variable));
+        }
+
+        if (result->kind == GDBWIRE_MI_LIST) {
+            stream = gdbwire_mi_list_stream_find(parser->streams, path, size);
+        }
+
+        if (stream) {
+            struct gdbwire_mi_result *element = result->variant.result, *next;
+            size_t index;
+
+            for (index = 0; element; ++index, element = next) {
+                next = element->next;
+                element->next = NULL;
+                if (index >= stream->streamed) {
+                    stream->callback(stream->context, token, element);
+                }
+            }
+
+            result->variant.result = NULL;
+        } else {
+            gdbwire_mi_parser_stream_results(parser, token,
+                result->variant.result, path, size);
+        }
+    }
+}
+
+/**
+ * Parse a single line of output in GDB/MI format with flex and bison.
+ *
+ * @param parser
+ * The parser context to operate on.
+ *
+ * @param line
+ * A line of output in GDB/MI format to be parsed, including its newline.
+ * The lexer scans the line where it is rather than copying it, so the
+ * two bytes following the line must be writable. They are used as the
+ * lexer's end of buffer markers and restored before returning.
+ *
+ * @param size
+ * The number of bytes in line.
+ *
+ * @param output
+ * Set to the output command parsed from the line.
+ *
+ * \return
+ * GDBWIRE_OK on success or appropriate error result on failure.
+ */
+static enum gdbwire_result
+gdbwire_mi_parser_lex_line(struct gdbwire_mi_parser *parser,
+    char *line, size_t size, struct gdbwire_mi_output **output)
+{
+    enum gdbwire_result result = GDBWIRE_OK;
+    YY_BUFFER_STATE state = 0;
+    char sentinel[2];
+    int pattern, mi_status;
+
+    /**
+     * Point flex directly at the line.
+     *
+     * Flex requires its buffer to end with two null bytes, so the two
+     * bytes after the line are saved and replaced while the line is lexed.
+     */
+    memcpy(sentinel, line + size, sizeof(sentinel));
+    line[size] = line[size + 1] = '\0';
+    state = gdbwire_mi__scan_buffer(line, size + 2, parser->mils);
+    GDBWIRE_ASSERT_GOTO(state, result, cleanup);
+    gdbwire_mi_set_column(1, parser->mils);
+
+    /* Iterate over all the tokens found in the scanner buffer */
+    do {
+        pattern = gdbwire_mi_lex(parser->mils);
+        if (pattern == 0)
+            break;
+        mi_status = gdbwire_mi_push_parse(parser->mipst, pattern, NULL,
+            parser->mils, output);
+    } while (mi_status == YYPUSH_MORE);
+
+    /**
+     * Flex null terminates each token in the buffer while it is being
+     * matched and only puts the original byte back when it scans the
+     * next one. Finish scanning the line so that it is left untouched.
+     */
+    while (pattern != 0) {
+        pattern = gdbwire_mi_lex(parser->mils);
+    }
+
+    /**
+     * The push parser will return,
+     * - 0 if parsing was successful (return is due to end-of-input).
+     * - 1 if parsing failed because of invalid input, i.e., input
+     *     that contains a syntax error or that causes YYABORT to be invoked.
+     * - 2 if parsing failed due to memory exhaustion. 
+     * - YYPUSH_MORE if more input is required to finish parsing the grammar. 
+     * Anything besides this would be unexpected.
+     *
+     * The grammar is designed to accept an infinate list of GDB/MI
+     * output commands. For this reason, YYPUSH_MORE is the expected
+     * return value of all the calls to gdbwire_mi_push_parse. However,
+     * in reality, gdbwire only translates a line at a time from GDB.
+     * When the line is finished, gdbwire_mi_lex returns 0, and the parsing
+     * is done.
+     */
+
+    /* Check mi_status, will be 1 on parse error, and YYPUSH_MORE on success */
+    GDBWIRE_ASSERT_GOTO(mi_status == 1 || mi_status == YYPUSH_MORE,
+        result, cleanup);
+
+cleanup:
+    /* Free the scanners buffer */
+    if (state) {
+        gdbwire_mi__delete_buffer(state, parser->mils);
+    }
+    memcpy(line + size, sentinel, sizeof(sentinel));
+    return result;
+}
+
+/**
+ * Parse a single line of output in GDB/MI format.
+ *
+ * The normal usage of this function is to call it over and over again with
+ * more data lines and wait for it to return an mi output command.
+ *
+ * @param parser
+ * The parser context to operate on.
  *
  * @param line
- * Will return as an allocated line if a line is available or NULL
- * otherwise. If this function does not return GDBWIRE_OK then ignore
- * the output of this parameter. It is the callers responsibility to
- * free the memory.
+ * A line of output in GDB/MI format to be parsed, including its newline.
+ * The two bytes following the line must be writable,
+ * see gdbwire_mi_parser_lex_line.
  *
- * @return
+ * @param size
+ * The number of bytes in line.
+ *
+ * \return
  * GDBWIRE_OK on success or appropriate error result on failure.
  */
 static enum gdbwire_result
-gdbwire_mi_parser_get_next_line(struct gdbwire_string *buffer,
-        struct gdbwire_string **line)
+gdbwire_mi_parser_parse_line(struct gdbwire_mi_parser *parser,
+    char *line, size_t size)
 {
+    struct gdbwire_mi_parser_callbacks callbacks =
+        gdbwire_mi_parser_get_callbacks(parser);
+    struct gdbwire_mi_output *output = 0;
+    struct gdbwire_mi_lexer_extra extra = { { 0, 0 }, 0 };
     enum gdbwire_result result = GDBWIRE_OK;
+    enum gdbwire_mi_interest interest = GDBWIRE_MI_INTEREST_FULL;
+    struct gdbwire_mi_list_stream *stream;
+    size_t arena_size = size * 4 + 256;
+    int streamed = 0;
+
+    GDBWIRE_ASSERT(parser && line);
 
-    GDBWIRE_ASSERT(buffer && line);
+    if (parser->filtering) {
+        interest = gdbwire_mi_parser_interest(parser, line, size);
+        if (interest == GDBWIRE_MI_INTEREST_NONE) {
+            return GDBWIRE_OK;
+        }
+    }
 
-    char *data = gdbwire_string_data(buffer);
-    size_t size = gdbwire_string_size(buffer);
-    size_t pos = gdbwire_string_find_first_of(buffer, "\r\n");
+    for (stream = parser->streams; stream; stream = stream->next) {
+        stream->streamed = 0;
+    }
 
     /**
-     * Search to see if a newline has been reached in gdb/mi.
-     * If a line of data has been recieved, process it.
+     * Everything parsed from the line is allocated from one arena.
+     * The parse tree is usually a few times the size of the line.
+     *
+     * When lists are streamed, a large line may need little more than
+     * one element at a time, so the arena starts smaller and grows.
      */
-    if (pos != size) {
-        int status;
+    if (interest != GDBWIRE_MI_INTEREST_FULL) {
+        arena_size = 256;
+    } else if (parser->streams && arena_size > 65536) {
+        arena_size = 65536;
+    }
 
-        /**
-         * We have the position of the newline character from
-         * gdbwire_string_find_first_of. However, the length must be
-         * calculated to make a copy of the line.
-         *
-         * This is either pos + 1 (for \r or \n) or pos + 1 + 1 for (\r\n).
-         * Check for\r\n for the special case.
-         */
-        size_t line_length = (data[pos] == '\r' && (pos + 1 < size) &&
-                data[pos + 1] == '\n') ? pos + 2 : pos + 1;
+    extra.arena = gdbwire_mi_arena_create(arena_size);
+    GDBWIRE_ASSERT(extra.arena);
 
-        /**
-         * - allocate the buffer
-         * - append the new line
-         * - append a null terminating character
-         * - if successful, delete the new line found from buffer
-         * - any failures cleanup and return an error
-         */
-        *line = gdbwire_string_create();
-        GDBWIRE_ASSERT(*line);
+    if (interest == GDBWIRE_MI_INTEREST_CLASS) {
+        output = gdbwire_mi_record_class(extra.arena, line, size);
+    }
+
+#if GDBWIRE_MI_FAST_PATH
+    if (!output && parser->fast_path) {
+        output = gdbwire_mi_fast_parse(extra.arena, parser->streams,
+            line, size);
+        streamed = output != NULL;
+    }
+#endif
 
-        status = gdbwire_string_append_data(*line, data, line_length);
-        GDBWIRE_ASSERT_GOTO(status == 0, result, cleanup);
+    if (!output) {
+        gdbwire_mi_set_extra(extra, parser->mils);
+        result = gdbwire_mi_parser_lex_line(parser, line, size, &output);
+        GDBWIRE_ASSERT_GOTO(result == GDBWIRE_OK, result, cleanup);
+    }
 
-        status = gdbwire_string_append_data(*line, "\0", 1);
-        GDBWIRE_ASSERT_GOTO(status == 0, result, cleanup);
+    /* Each GDB/MI line should produce an output command */
+    GDBWIRE_ASSERT_GOTO(output, result, cleanup);
+
+    if (parser->streams && !streamed &&
+            output->kind == GDBWIRE_MI_OUTPUT_RESULT) {
+        char path[GDBWIRE_MI_LIST_STREAM_PATH_MAX];
+        gdbwire_mi_parser_stream_results(parser,
+            output->variant.result_record->token,
+            output->variant.result_record->result, path, 0);
+    }
 
-        status = gdbwire_string_erase(buffer, 0, line_length);
-        GDBWIRE_ASSERT_GOTO(status == 0, result, cleanup);
+    /* The gdbwire callbacks report the line of prompts and parse errors */
+    if (parser->keep_lines || output->kind == GDBWIRE_MI_OUTPUT_PROMPT ||
+            output->kind == GDBWIRE_MI_OUTPUT_PARSE_ERROR) {
+        output->line = gdbwire_mi_arena_strndup(extra.arena, line, size);
+        GDBWIRE_ASSERT_GOTO(output->line, result, cleanup);
     }
 
-    return result;
+    /* The output owns the arena from now on */
+    output->arena = extra.arena;
+    extra.arena = 0;
+
+    callbacks.gdbwire_mi_output_callback(callbacks.context, output);
 
 cleanup:
-    gdbwire_string_destroy(*line);
-    *line = 0;
+    gdbwire_mi_arena_destroy(extra.arena);
     return result;
+}
 
+/**
+ * Find the end of the next line available in the buffer.
+ *
+ * @param data
+ * The data the user has pushed onto the gdbwire_mi parser that has not
+ * been parsed yet.
+ *
+ * @param size
+ * The number of bytes in data.
+ *
+ * @param line_length
+ * Set to the length of the line, including its newline, if one is found.
+ *
+ * @return
+ * True if data starts with a complete line, false otherwise.
+ */
+static int
+gdbwire_mi_parser_get_next_line(const char *data, size_t size,
+        size_t *line_length)
+{
+    size_t pos;
+
+    for (pos = 0; pos < size; ++pos) {
+        if (data[pos] == '\r' || data[pos] == '\n') {
+            /**
+             * The line ends with \r, \n or \r\n.
+             * Check for \r\n for the special case.
+             */
+            *line_length = (data[pos] == '\r' && (pos + 1 < size) &&
+                    data[pos + 1] == '\n') ? pos + 2 : pos + 1;
+            return 1;
+        }
+    }
+
+    return 0;
 }
 
 enum gdbwire_result
@@ -1953,10 +3363,9 @@ enum gdbwire_result
 gdbwire_mi_parser_push_data(struct gdbwire_mi_parser *parser, const char *data,
     size_t size)
 {
-    struct gdbwire_string *line = 0;
     enum gdbwire_result result = GDBWIRE_OK;
     int has_newline = 0;
-    size_t index;
+    size_t index, offset = 0, line_length;
 
     GDBWIRE_ASSERT(parser && data);
 
@@ -1978,241 +3387,358 @@ gdbwire_mi_parser_push_data(struct gdbwire_mi_parser *parser, const char *data,
 
     GDBWIRE_ASSERT(gdbwire_string_append_data(parser->buffer, data, size) == 0);
 
+    /**
+     * Parse each complete line in place, moving an offset past it.
+     *
+     * The parsed lines are only removed from the buffer once all of them
+     * have been parsed. Removing each line as it is parsed would move the
+     * rest of the buffer every time, which is quadratic when gdb sends
+     * many lines at once.
+     *
+     * The lexer needs two writable bytes after each line. Padding the
+     * buffer while parsing guarantees them for the last line as well.
+     */
     if (has_newline) {
-        for (;;) {
-            result = gdbwire_mi_parser_get_next_line(parser->buffer, &line);
+        char *buffer;
+        size_t buffer_size = gdbwire_string_size(parser->buffer);
+
+        GDBWIRE_ASSERT(gdbwire_string_append_data(parser->buffer,
+            "\0\0", 2) == 0);
+        buffer = gdbwire_string_data(parser->buffer);
+
+        while (gdbwire_mi_parser_get_next_line(buffer + offset,
+                buffer_size - offset, &line_length)) {
+            result = gdbwire_mi_parser_parse_line(parser,
+                buffer + offset, line_length);
+            offset += line_length;
             GDBWIRE_ASSERT_GOTO(result == GDBWIRE_OK, result, cleanup);
+        }
 
-            if (line) {
-                result = gdbwire_mi_parser_parse_line(parser,
-                    gdbwire_string_data(line));
-                gdbwire_string_destroy(line);
-                line = 0;
-                GDBWIRE_ASSERT_GOTO(result == GDBWIRE_OK, result, cleanup);
-            } else {
-                break;
-            }
+cleanup:
+        gdbwire_string_erase(parser->buffer, buffer_size, 2);
+        if (offset > 0) {
+            gdbwire_string_erase(parser->buffer, 0, offset);
         }
     }
 
-cleanup:
     return result;
 }
 /***** End of gdbwire_mi_parser.c ********************************************/
 /***** Begin file gdbwire_mi_pt_alloc.c **************************************/
 #include <stdlib.h>
+#include <string.h>
 
 /* #include "gdbwire_mi_pt.h" */
-/***** Include gdbwire_mi_pt_alloc.h in the middle of gdbwire_mi_pt_alloc.c **/
-/***** Begin file gdbwire_mi_pt_alloc.h **************************************/
-#ifndef GDBWIRE_MI_PT_ALLOC_H
-#define GDBWIRE_MI_PT_ALLOC_H
-
-#ifdef __cplusplus 
-extern "C" { 
-#endif 
+/* #include "gdbwire_mi_pt_alloc.h" */
 
 /**
- * Responsible for allocating and deallocating gdbwire_mi_pt objects.
+ * A block of arena memory.
+ *
+ * The arena hands out memory from the newest block until it is full,
+ * and then allocates a new block at least twice as big.
  */
+struct gdbwire_mi_arena_block {
+    /* The block allocated before this one or NULL if none */
+    struct gdbwire_mi_arena_block *next;
+    /* The number of bytes in the block, including this header */
+    size_t size;
+    /* The number of bytes of the block handed out so far */
+    size_t used;
+};
 
-/* struct gdbwire_mi_output */
-struct gdbwire_mi_output *gdbwire_mi_output_alloc(void);
-void gdbwire_mi_output_free(struct gdbwire_mi_output *param);
+struct gdbwire_mi_arena {
+    /* The newest block, which allocations are made from */
+    struct gdbwire_mi_arena_block *block;
+};
 
-/* struct gdbwire_mi_result_record */
-struct gdbwire_mi_result_record *gdbwire_mi_result_record_alloc(void);
-void gdbwire_mi_result_record_free(struct gdbwire_mi_result_record *param);
+/* The alignment of every arena allocation */
+union gdbwire_mi_arena_align {
+    void *pointer;
+    long integer;
+    double floating;
+};
 
-/* struct gdbwire_mi_result */
-struct gdbwire_mi_result *gdbwire_mi_result_alloc(void);
-void gdbwire_mi_result_free(struct gdbwire_mi_result *param);
+#define GDBWIRE_MI_ARENA_ALIGN sizeof(union gdbwire_mi_arena_align)
+#define GDBWIRE_MI_ARENA_ROUND(size) \
+    (((size) + GDBWIRE_MI_ARENA_ALIGN - 1) & ~(GDBWIRE_MI_ARENA_ALIGN - 1))
+#define GDBWIRE_MI_ARENA_HEADER \
+    GDBWIRE_MI_ARENA_ROUND(sizeof(struct gdbwire_mi_arena_block))
 
-/* struct gdbwire_mi_oob_record */
-struct gdbwire_mi_oob_record *gdbwire_mi_oob_record_alloc(void);
-void gdbwire_mi_oob_record_free(struct gdbwire_mi_oob_record *param);
+/**
+ * Add a block to the arena big enough to hold size more bytes.
+ *
+ * @return
+ * 0 on success or -1 if out of memory.
+ */
+static int
+gdbwire_mi_arena_grow(struct gdbwire_mi_arena *arena, size_t size)
+{
+    struct gdbwire_mi_arena_block *block;
+    size_t block_size = GDBWIRE_MI_ARENA_HEADER + size;
 
-/* struct gdbwire_mi_async_record */
-struct gdbwire_mi_async_record *gdbwire_mi_async_record_alloc(void);
-void gdbwire_mi_async_record_free(struct gdbwire_mi_async_record *param);
+    if (arena->block && block_size < arena->block->size * 2) {
+        block_size = arena->block->size * 2;
+    }
 
-/* struct gdbwire_mi_stream_record */
-struct gdbwire_mi_stream_record *gdbwire_mi_stream_record_alloc(void);
-void gdbwire_mi_stream_record_free(struct gdbwire_mi_stream_record *param);
+    block = malloc(block_size);
+    if (!block) {
+        return -1;
+    }
 
-#ifdef __cplusplus 
-}
-#endif 
+    block->next = arena->block;
+    block->size = block_size;
+    block->used = GDBWIRE_MI_ARENA_HEADER;
+    arena->block = block;
 
-#endif /* GDBWIRE_MI_PT_ALLOC_H */
-/***** End of gdbwire_mi_pt_alloc.h ******************************************/
-/***** Continuing where we left off in gdbwire_mi_pt_alloc.c *****************/
+    return 0;
+}
 
-/* struct gdbwire_mi_output */
-struct gdbwire_mi_output *
-gdbwire_mi_output_alloc(void)
+struct gdbwire_mi_arena *
+gdbwire_mi_arena_create(size_t size)
 {
-    return calloc(1, sizeof (struct gdbwire_mi_output));
+    struct gdbwire_mi_arena arena = { NULL };
+    struct gdbwire_mi_arena *result;
+
+    /* The arena keeps itself in its first block */
+    size += GDBWIRE_MI_ARENA_ROUND(sizeof(struct gdbwire_mi_arena));
+    if (gdbwire_mi_arena_grow(&arena, size) == -1) {
+        return NULL;
+    }
+
+    result = gdbwire_mi_arena_alloc(&arena, sizeof(struct gdbwire_mi_arena));
+    *result = arena;
+
+    return result;
 }
 
 void
-gdbwire_mi_output_free(struct gdbwire_mi_output *param)
+gdbwire_mi_arena_destroy(struct gdbwire_mi_arena *arena)
 {
-    if (param) {
-        switch (param->kind) {
-            case GDBWIRE_MI_OUTPUT_OOB:
-                gdbwire_mi_oob_record_free(param->variant.oob_record);
-                param->variant.oob_record = NULL;
-                break;
-            case GDBWIRE_MI_OUTPUT_RESULT:
-                gdbwire_mi_result_record_free(param->variant.result_record);
-                param->variant.result_record = NULL;
-                break;
-            case GDBWIRE_MI_OUTPUT_PROMPT:
-                break;
-            case GDBWIRE_MI_OUTPUT_PARSE_ERROR:
-                free(param->variant.error.token);
-                param->variant.error.token = NULL;
-                break;
-        }
-
-        free(param->line);
-        param->line = 0;
-
-        gdbwire_mi_output_free(param->next);
-        param->next = NULL;
+    if (arena) {
+        struct gdbwire_mi_arena_block *block = arena->block;
 
-        free(param);
-        param = NULL;
+        /* The arena itself is freed with the oldest block */
+        while (block) {
+            struct gdbwire_mi_arena_block *next = block->next;
+            free(block);
+            block = next;
+        }
     }
 }
 
-/* struct gdbwire_mi_result_record */
-struct gdbwire_mi_result_record *
-gdbwire_mi_result_record_alloc(void)
+void
+gdbwire_mi_arena_mark(struct gdbwire_mi_arena *arena,
+        struct gdbwire_mi_arena_mark *mark)
 {
-    return calloc(1, sizeof (struct gdbwire_mi_result_record));
+    mark->block = arena->block;
+    mark->used = arena->block->used;
 }
 
 void
-gdbwire_mi_result_record_free(struct gdbwire_mi_result_record *param)
+gdbwire_mi_arena_release(struct gdbwire_mi_arena *arena,
+        const struct gdbwire_mi_arena_mark *mark)
+{
+    while (arena->block != mark->block) {
+        struct gdbwire_mi_arena_block *next = arena->block->next;
+        free(arena->block);
+        arena->block = next;
+    }
+
+    arena->block->used = mark->used;
+}
+
+/**
+ * Allocate memory from an arena without clearing it.
+ *
+ * The strings are written over completely, so clearing them first
+ * would only touch the memory twice.
+ */
+static char *
+gdbwire_mi_arena_reserve(struct gdbwire_mi_arena *arena, size_t size)
 {
-    if (param) {
-        free(param->token);
+    char *result;
+
+    size = GDBWIRE_MI_ARENA_ROUND(size);
+    if (arena->block->size - arena->block->used < size) {
+        if (gdbwire_mi_arena_grow(arena, size) == -1) {
+            return NULL;
+        }
+    }
+
+    result = (char *)arena->block + arena->block->used;
+    arena->block->used += size;
+
+    return result;
+}
 
-        gdbwire_mi_result_free(param->result);
-        param->result = NULL;
+void *
+gdbwire_mi_arena_alloc(struct gdbwire_mi_arena *arena, size_t size)
+{
+    char *result = gdbwire_mi_arena_reserve(arena, size);
 
-        free(param);
-        param = NULL;
+    if (result) {
+        memset(result, 0, GDBWIRE_MI_ARENA_ROUND(size));
     }
+
+    return result;
 }
 
-/* struct gdbwire_mi_result */
-struct gdbwire_mi_result *
-gdbwire_mi_result_alloc(void)
+char *
+gdbwire_mi_arena_strndup(struct gdbwire_mi_arena *arena,
+        const char *str, size_t size)
 {
-    return calloc(1, sizeof (struct gdbwire_mi_result));
+    char *result = gdbwire_mi_arena_reserve(arena, size + 1);
+
+    if (result) {
+        memcpy(result, str, size);
+        result[size] = 0;
+    }
+
+    return result;
 }
 
-void
-gdbwire_mi_result_free(struct gdbwire_mi_result *param)
+/**
+ * GDB/MI escapes characters in the c-string rule.
+ *
+ * The c-string starts and ends with a ".
+ * Each " in the c-string is escaped with a \. So GDB turns " into \".
+ * Each \ in the string is then escaped with a \. So GDB turns \ into \\.
+ *
+ * Remove the GDB/MI escape characters to provide back to the user the
+ * original characters that GDB was intending to transmit. So
+ *   \" -> "
+ *   \\ -> \
+ *   \n -> new line
+ *   \r -> carriage return
+ *   \t -> tab
+ *
+ * See gdbwire_mi_grammar.txt (GDB/MI Clarifications) for more information.
+ *
+ * The result is never longer than str. The runs of characters between
+ * escapes are found with memchr and copied whole, since console and log
+ * output is mostly text with only a newline escaped at the end.
+ */
+char *
+gdbwire_mi_arena_unescape(struct gdbwire_mi_arena *arena,
+        const char *str, size_t length)
 {
-    if (param) {
-        if (param->variable) {
-            free(param->variable);
-            param->variable = NULL;
+    const char *cur = str + 1, *end = str + length - 1, *escape;
+    char *result, *r;
+
+    result = gdbwire_mi_arena_reserve(arena, length - 1);
+    if (!result) {
+        return NULL;
+    }
+
+    for (r = result; cur < end; ) {
+        escape = memchr(cur, '\\', end - cur);
+        if (!escape) {
+            memcpy(r, cur, end - cur);
+            r += end - cur;
+            break;
         }
 
-        switch (param->kind) {
-            case GDBWIRE_MI_CSTRING:
-                if (param->variant.cstring) {
-                    free(param->variant.cstring);
-                    param->variant.cstring = NULL;
-                }
+        memcpy(r, cur, escape - cur);
+        r += escape - cur;
+        cur = escape + 2;
+
+        switch (escape[1]) {
+            case 'n':
+                *r++ = '\n';
                 break;
-            case GDBWIRE_MI_TUPLE:
-            case GDBWIRE_MI_LIST:
-                gdbwire_mi_result_free(param->variant.result);
-                param->variant.result = NULL;
+            case 'b':
+                *r++ = '\b';
+                break;
+            case 't':
+                *r++ = '\t';
+                break;
+            case 'f':
+                *r++ = '\f';
+                break;
+            case 'r':
+                *r++ = '\r';
+                break;
+            case 'e':
+                *r++ = '\033';
+                break;
+            case 'a':
+                *r++ = '\007';
+                break;
+            case '"':
+                *r++ = '\"';
+                break;
+            case '\\':
+                *r++ = '\\';
+                break;
+            default:
+                /* Keep the backslash and look at the next character again */
+                *r++ = '\\';
+                cur = escape + 1;
                 break;
         }
+    }
 
-        gdbwire_mi_result_free(param->next);
-        param->next = NULL;
+    *r = 0;
 
-        free(param);
-        param = NULL;
-    }
+    return result;
 }
 
-/* struct gdbwire_mi_oob_record */
-struct gdbwire_mi_oob_record *
-gdbwire_mi_oob_record_alloc(void)
+/* struct gdbwire_mi_output */
+struct gdbwire_mi_output *
+gdbwire_mi_output_alloc(struct gdbwire_mi_arena *arena)
 {
-    return calloc(1, sizeof (struct gdbwire_mi_oob_record));
+    return gdbwire_mi_arena_alloc(arena, sizeof (struct gdbwire_mi_output));
 }
 
 void
-gdbwire_mi_oob_record_free(struct gdbwire_mi_oob_record *param)
+gdbwire_mi_output_free(struct gdbwire_mi_output *param)
 {
-    if (param) {
-        switch(param->kind) {
-            case GDBWIRE_MI_ASYNC:
-                gdbwire_mi_async_record_free(param->variant.async_record);
-                param->variant.async_record = NULL;
-                break;
-            case GDBWIRE_MI_STREAM:
-                gdbwire_mi_stream_record_free(param->variant.stream_record);
-                param->variant.stream_record = NULL;
-                break;
-        }
+    while (param) {
+        struct gdbwire_mi_output *next = param->next;
 
-        free(param);
-        param = NULL;
+        /* The output and its parse tree all live in the arena */
+        gdbwire_mi_arena_destroy(param->arena);
+        param = next;
     }
 }
 
-/* struct gdbwire_mi_async_record */
-struct gdbwire_mi_async_record *
-gdbwire_mi_async_record_alloc(void)
+/* struct gdbwire_mi_result_record */
+struct gdbwire_mi_result_record *
+gdbwire_mi_result_record_alloc(struct gdbwire_mi_arena *arena)
 {
-    return calloc(1, sizeof (struct gdbwire_mi_async_record));
+    return gdbwire_mi_arena_alloc(arena,
+            sizeof (struct gdbwire_mi_result_record));
 }
 
-void
-gdbwire_mi_async_record_free(struct gdbwire_mi_async_record *param)
+/* struct gdbwire_mi_result */
+struct gdbwire_mi_result *
+gdbwire_mi_result_alloc(struct gdbwire_mi_arena *arena)
 {
-    if (param) {
-        free(param->token);
-
-        gdbwire_mi_result_free(param->result);
-        param->result = NULL;
-
-        free(param);
-        param = NULL;
-    }
+    return gdbwire_mi_arena_alloc(arena, sizeof (struct gdbwire_mi_result));
 }
 
-/* struct gdbwire_mi_stream_record */
-struct gdbwire_mi_stream_record *
-gdbwire_mi_stream_record_alloc(void)
+/* struct gdbwire_mi_oob_record */
+struct gdbwire_mi_oob_record *
+gdbwire_mi_oob_record_alloc(struct gdbwire_mi_arena *arena)
 {
-    return calloc(1, sizeof (struct gdbwire_mi_stream_record));
+    return gdbwire_mi_arena_alloc(arena,
+            sizeof (struct gdbwire_mi_oob_record));
 }
 
-void
-gdbwire_mi_stream_record_free(struct gdbwire_mi_stream_record *param)
+/* struct gdbwire_mi_async_record */
+struct gdbwire_mi_async_record *
+gdbwire_mi_async_record_alloc(struct gdbwire_mi_arena *arena)
 {
-    if (param) {
-        if (param->cstring) {
-            free(param->cstring);
-            param->cstring = NULL;
-        }
+    return gdbwire_mi_arena_alloc(arena,
+            sizeof (struct gdbwire_mi_async_record));
+}
 
-        free(param);
-        param = NULL;
-    }
+/* struct gdbwire_mi_stream_record */
+struct gdbwire_mi_stream_record *
+gdbwire_mi_stream_record_alloc(struct gdbwire_mi_arena *arena)
+{
+    return gdbwire_mi_arena_alloc(arena,
+            sizeof (struct gdbwire_mi_stream_record));
 }
 /***** End of gdbwire_mi_pt_alloc.c ******************************************/
 /***** Begin file gdbwire_mi_pt.c ********************************************/
@@ -2647,12 +4173,97 @@ struct gdbwire_mi_command {
  * gdbwire_mi_command_free when you are done with it.
  *
  * @return
- * The result of this function.
+ * The result of this function.
+ */
+enum gdbwire_result gdbwire_get_mi_command(
+        enum gdbwire_mi_command_kind kind,
+        struct gdbwire_mi_result_record *result_record,
+        struct gdbwire_mi_command **out_mi_command);
+
+/**
+ * Get the breakpoint described by a breakpoint async record.
+ *
+ * The =breakpoint-created and =breakpoint-modified async records
+ * describe the breakpoint with the same bkpt tuple that -break-info
+ * uses for each row of its table.
+ *
+ * It also converts the elements of a streamed -break-info body one at
+ * a time. After the first, GDB leaves out the bkpt variable of those.
+ *
+ * @param result
+ * The results of the async record, starting with bkpt={...}. The
+ * locations of a multiple location breakpoint follow it as tuples.
+ *
+ * @param out_mi_command
+ * Will return an allocated GDBWIRE_MI_BREAK_INFO command holding the
+ * single breakpoint if GDBWIRE_OK is returned from this function.
+ * You should free this memory with gdbwire_mi_command_free when you
+ * are done with it.
+ *
+ * @return
+ * The result of this function.
+ */
+enum gdbwire_result gdbwire_get_mi_breakpoint(
+        struct gdbwire_mi_result *result,
+        struct gdbwire_mi_command **out_mi_command);
+
+/**
+ * The number of hash slots in a gdbwire_mi_schema.
+ *
+ * A schema can hold at most half this many fields.
+ */
+#define GDBWIRE_MI_SCHEMA_SLOTS 64
+
+/**
+ * The fields to extract from the results of a tuple.
+ *
+ * Declare a schema once for each kind of tuple, with GDBWIRE_MI_SCHEMA,
+ * and extract the fields with gdbwire_mi_schema_extract. Each result is
+ * then matched to its field with one hash lookup, rather than by
+ * comparing it against every field name in turn.
+ */
+struct gdbwire_mi_schema {
+    /* The names of the fields, in the order their values are extracted */
+    const char *const *names;
+    /* The number of names */
+    size_t count;
+    /* A hash table of the index of each name plus one, 0 if empty */
+    unsigned char slots[GDBWIRE_MI_SCHEMA_SLOTS];
+    /* Non-zero once the hash table has been built */
+    int initialized;
+};
+
+/**
+ * Initialize a gdbwire_mi_schema from an array of field names.
+ *
+ * The hash table is built the first time the schema is used. An array
+ * of more than GDBWIRE_MI_SCHEMA_SLOTS / 2 names does not compile.
+ */
+#define GDBWIRE_MI_SCHEMA(names) \
+    { names, sizeof(names) / sizeof((names)[0]) + 0 * sizeof(char[ \
+        sizeof(names) / sizeof((names)[0]) <= GDBWIRE_MI_SCHEMA_SLOTS / 2 ? \
+        1 : -1]), { 0 }, 0 }
+
+/**
+ * Extract the fields of a schema from the results of a tuple.
+ *
+ * @param schema
+ * The fields to extract.
+ *
+ * @param result
+ * The first result of the tuple.
+ *
+ * @param values
+ * An array of schema->count values. Each is set to the cstring of the
+ * last result named by the field at the same index of the schema,
+ * or NULL if the tuple has no such result. All of them are NULL if the
+ * schema has more than GDBWIRE_MI_SCHEMA_SLOTS / 2 fields.
+ *
+ * @return
+ * The number of results that were not cstrings. These are skipped.
  */
-enum gdbwire_result gdbwire_get_mi_command(
-        enum gdbwire_mi_command_kind kind,
-        struct gdbwire_mi_result_record *result_record,
-        struct gdbwire_mi_command **out_mi_command);
+size_t gdbwire_mi_schema_extract(struct gdbwire_mi_schema *schema,
+        struct gdbwire_mi_result *result, char **values);
 
 /**
  * Free the gdbwire mi command.
@@ -2670,6 +4281,94 @@ void gdbwire_mi_command_free(struct gdbwire_mi_command *mi_command);
 /***** End of gdbwire_mi_command.h *******************************************/
 /***** Continuing where we left off in gdbwire_mi_command.c ******************/
 
+/**
+ * Hash a field name into a gdbwire_mi_schema's slots.
+ *
+ * @param name
+ * The field name.
+ *
+ * @return
+ * The first slot to look for the name in.
+ */
+static size_t
+gdbwire_mi_schema_hash(const char *name)
+{
+    /* FNV-1a */
+    unsigned long hash = 2166136261UL;
+
+    for (; *name; ++name) {
+        hash = ((hash ^ (unsigned char)*name) * 16777619UL) & 0xffffffffUL;
+    }
+
+    return hash & (GDBWIRE_MI_SCHEMA_SLOTS - 1);
+}
+
+/**
+ * Build the hash table of a schema.
+ *
+ * @param schema
+ * The schema to build the hash table of.
+ *
+ * @return
+ * GDBWIRE_OK on success or GDBWIRE_ASSERT if the schema has too many
+ * fields for the table to always have an empty slot.
+ */
+static enum gdbwire_result
+gdbwire_mi_schema_init(struct gdbwire_mi_schema *schema)
+{
+    size_t index, slot;
+
+    GDBWIRE_ASSERT(schema->count <= GDBWIRE_MI_SCHEMA_SLOTS / 2);
+
+    for (index = 0; index < schema->count; ++index) {
+        slot = gdbwire_mi_schema_hash(schema->names[index]);
+        while (schema->slots[slot]) {
+            slot = (slot + 1) & (GDBWIRE_MI_SCHEMA_SLOTS - 1);
+        }
+        schema->slots[slot] = (unsigned char)(index + 1);
+    }
+
+    schema->initialized = 1;
+
+    return GDBWIRE_OK;
+}
+
+size_t
+gdbwire_mi_schema_extract(struct gdbwire_mi_schema *schema,
+        struct gdbwire_mi_result *result, char **values)
+{
+    size_t index, slot, skipped = 0;
+
+    for (index = 0; index < schema->count; ++index) {
+        values[index] = 0;
+    }
+
+    if (!schema->initialized &&
+            gdbwire_mi_schema_init(schema) != GDBWIRE_OK) {
+        return 0;
+    }
+
+    for (; result; result = result->next) {
+        if (result->kind != GDBWIRE_MI_CSTRING) {
+            ++skipped;
+            continue;
+        }
+
+        /* The table is never full, so the probe ends at an empty slot */
+        slot = gdbwire_mi_schema_hash(result->variable);
+        while (schema->slots[slot]) {
+            index = schema->slots[slot] - 1;
+            if (strcmp(schema->names[index], result->variable) == 0) {
+                values[index] = result->variant.cstring;
+                break;
+            }
+            slot = (slot + 1) & (GDBWIRE_MI_SCHEMA_SLOTS - 1);
+        }
+    }
+
+    return skipped;
+}
+
 /**
  * Free a source file list.
  *
@@ -2767,6 +4466,41 @@ gdbwire_string_to_ulong(char *str, unsigned long *num)
     return result;
 }
 
+/* The fields of a breakpoint tuple */
+enum gdbwire_mi_breakpoint_field {
+    GDBWIRE_MI_BREAKPOINT_NUMBER,
+    GDBWIRE_MI_BREAKPOINT_ENABLED,
+    GDBWIRE_MI_BREAKPOINT_ADDR,
+    GDBWIRE_MI_BREAKPOINT_CATCH_TYPE,
+    GDBWIRE_MI_BREAKPOINT_TYPE,
+    GDBWIRE_MI_BREAKPOINT_DISP,
+    GDBWIRE_MI_BREAKPOINT_FUNC,
+    GDBWIRE_MI_BREAKPOINT_FILE,
+    GDBWIRE_MI_BREAKPOINT_FULLNAME,
+    GDBWIRE_MI_BREAKPOINT_LINE,
+    GDBWIRE_MI_BREAKPOINT_TIMES,
+    GDBWIRE_MI_BREAKPOINT_ORIGINAL_LOCATION,
+    GDBWIRE_MI_BREAKPOINT_FIELDS
+};
+
+static const char *const gdbwire_mi_breakpoint_fields[] = {
+    "number",
+    "enabled",
+    "addr",
+    "catch-type",
+    "type",
+    "disp",
+    "func",
+    "file",
+    "fullname",
+    "line",
+    "times",
+    "original-location"
+};
+
+static struct gdbwire_mi_schema gdbwire_mi_breakpoint_schema =
+    GDBWIRE_MI_SCHEMA(gdbwire_mi_breakpoint_fields);
+
 /**
  * Handle breakpoints from the -break-info command.
  *
@@ -2788,75 +4522,69 @@ break_info_for_breakpoint(struct gdbwire_mi_result *mi_result,
 
     struct gdbwire_mi_breakpoint *breakpoint = 0;
 
-    char *number = 0;
+    char *fields[GDBWIRE_MI_BREAKPOINT_FIELDS];
+    char *number, *catch_type, *address, *type, *disp;
+    char *func_name, *file, *fullname, *original_location;
     int multi = 0;
     int from_multi = 0;
-    char *catch_type = 0;
     int pending = 0;
     int enabled = 0;
-    char *address = 0;
-    char *type = 0;
     enum gdbwire_mi_breakpoint_disp_kind disp_kind = GDBWIRE_MI_BP_DISP_UNKNOWN;
-    char *func_name = 0;
-    char *file = 0;
-    char *fullname = 0;
     unsigned long line = 0;
     unsigned long times = 0;
-    char *original_location = 0;
 
     GDBWIRE_ASSERT(mi_result);
     GDBWIRE_ASSERT(bkpt);
 
     *bkpt = 0;
 
-    while (mi_result) {
-        if (mi_result->kind == GDBWIRE_MI_CSTRING) {
-            if (strcmp(mi_result->variable, "number") == 0) {
-                number = mi_result->variant.cstring;
+    gdbwire_mi_schema_extract(&gdbwire_mi_breakpoint_schema, mi_result, fields);
 
-                if (strstr(number, ".") != NULL) {
-                    from_multi = 1;
-                }
-            } else if (strcmp(mi_result->variable, "enabled") == 0) {
-                enabled = mi_result->variant.cstring[0] == 'y';
-            } else if (strcmp(mi_result->variable, "addr") == 0) {
-                multi = strcmp(mi_result->variant.cstring, "<MULTIPLE>") == 0;
-                pending = strcmp(mi_result->variant.cstring, "<PENDING>") == 0;
-                address = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "catch-type") == 0) {
-                catch_type = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "type") == 0) {
-                type = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "disp") == 0) {
-                if (strcmp(mi_result->variant.cstring, "del") == 0) {
-                    disp_kind = GDBWIRE_MI_BP_DISP_DELETE;
-                } else if (strcmp(mi_result->variant.cstring, "dstp") == 0) {
-                    disp_kind = GDBWIRE_MI_BP_DISP_DELETE_NEXT_STOP;
-                } else if (strcmp(mi_result->variant.cstring, "dis") == 0) {
-                    disp_kind = GDBWIRE_MI_BP_DISP_DISABLE;
-                } else if (strcmp(mi_result->variant.cstring, "keep") == 0) {
-                    disp_kind = GDBWIRE_MI_BP_DISP_KEEP;
-                } else {
-                    return GDBWIRE_LOGIC;
-                }
-            } else if (strcmp(mi_result->variable, "func") == 0) {
-                func_name = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "file") == 0) {
-                file = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "fullname") == 0) {
-                fullname = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "line") == 0) {
-                GDBWIRE_ASSERT(gdbwire_string_to_ulong(
-                        mi_result->variant.cstring, &line) == GDBWIRE_OK);
-            } else if (strcmp(mi_result->variable, "times") == 0) {
-                GDBWIRE_ASSERT(gdbwire_string_to_ulong(
-                        mi_result->variant.cstring, &times) == GDBWIRE_OK);
-            } else if (strcmp(mi_result->variable, "original-location") == 0) {
-                original_location = mi_result->variant.cstring;
-            }
+    number = fields[GDBWIRE_MI_BREAKPOINT_NUMBER];
+    catch_type = fields[GDBWIRE_MI_BREAKPOINT_CATCH_TYPE];
+    address = fields[GDBWIRE_MI_BREAKPOINT_ADDR];
+    type = fields[GDBWIRE_MI_BREAKPOINT_TYPE];
+    disp = fields[GDBWIRE_MI_BREAKPOINT_DISP];
+    func_name = fields[GDBWIRE_MI_BREAKPOINT_FUNC];
+    file = fields[GDBWIRE_MI_BREAKPOINT_FILE];
+    fullname = fields[GDBWIRE_MI_BREAKPOINT_FULLNAME];
+    original_location = fields[GDBWIRE_MI_BREAKPOINT_ORIGINAL_LOCATION];
+
+    if (number) {
+        from_multi = strstr(number, ".") != NULL;
+    }
+
+    if (fields[GDBWIRE_MI_BREAKPOINT_ENABLED]) {
+        enabled = fields[GDBWIRE_MI_BREAKPOINT_ENABLED][0] == 'y';
+    }
+
+    if (address) {
+        multi = strcmp(address, "<MULTIPLE>") == 0;
+        pending = strcmp(address, "<PENDING>") == 0;
+    }
+
+    if (disp) {
+        if (strcmp(disp, "del") == 0) {
+            disp_kind = GDBWIRE_MI_BP_DISP_DELETE;
+        } else if (strcmp(disp, "dstp") == 0) {
+            disp_kind = GDBWIRE_MI_BP_DISP_DELETE_NEXT_STOP;
+        } else if (strcmp(disp, "dis") == 0) {
+            disp_kind = GDBWIRE_MI_BP_DISP_DISABLE;
+        } else if (strcmp(disp, "keep") == 0) {
+            disp_kind = GDBWIRE_MI_BP_DISP_KEEP;
+        } else {
+            return GDBWIRE_LOGIC;
         }
+    }
 
-        mi_result = mi_result->next;
+    if (fields[GDBWIRE_MI_BREAKPOINT_LINE]) {
+        GDBWIRE_ASSERT(gdbwire_string_to_ulong(
+                fields[GDBWIRE_MI_BREAKPOINT_LINE], &line) == GDBWIRE_OK);
+    }
+
+    if (fields[GDBWIRE_MI_BREAKPOINT_TIMES]) {
+        GDBWIRE_ASSERT(gdbwire_string_to_ulong(
+                fields[GDBWIRE_MI_BREAKPOINT_TIMES], &times) == GDBWIRE_OK);
     }
 
     /* Validate required fields before proceeding. */
@@ -2924,7 +4652,8 @@ break_info(
     enum gdbwire_result result = GDBWIRE_OK;
     struct gdbwire_mi_result *mi_result;
     struct gdbwire_mi_command *mi_command = 0;
-    struct gdbwire_mi_breakpoint *breakpoints = 0, *cur_bkpt;
+    struct gdbwire_mi_breakpoint *breakpoints = 0, *cur_bkpt = 0;
+    struct gdbwire_mi_breakpoint *cur_multi = 0;
     int found_body = 0;
 
     GDBWIRE_ASSERT(result_record);
@@ -2987,20 +4716,27 @@ break_info(
         }
 
         if (bkpt->from_multi) {
+            /* A location can not come before its breakpoint */
+            if (!cur_bkpt) {
+                gdbwire_mi_breakpoints_free(bkpt);
+                result = GDBWIRE_LOGIC;
+                goto cleanup;
+            }
 
             bkpt->multi_breakpoint = cur_bkpt;
 
-            /* Append breakpoint to the multiple location breakpoints */
-            if (cur_bkpt->multi_breakpoints) {
-                struct gdbwire_mi_breakpoint *multi =
-                    cur_bkpt->multi_breakpoints;
-                while (multi->next) {
-                    multi = multi->next;
-                }
-                multi->next = bkpt;
+            /**
+             * Append breakpoint to the multiple location breakpoints.
+             *
+             * The last location is remembered since a breakpoint may
+             * have thousands of them.
+             */
+            if (cur_multi && cur_multi->multi_breakpoint == cur_bkpt) {
+                cur_multi->next = bkpt;
             } else {
                 cur_bkpt->multi_breakpoints = bkpt;
             }
+            cur_multi = bkpt;
         } else {
             /* Append breakpoint to the list of breakpoints */
             if (breakpoints) {
@@ -3030,6 +4766,93 @@ cleanup:
     return result;
 }
 
+enum gdbwire_result
+gdbwire_get_mi_breakpoint(struct gdbwire_mi_result *mi_result,
+        struct gdbwire_mi_command **out)
+{
+    enum gdbwire_result result = GDBWIRE_OK;
+    struct gdbwire_mi_command *mi_command = 0;
+    struct gdbwire_mi_breakpoint *breakpoint = 0, *bkpt, *last = 0;
+
+    GDBWIRE_ASSERT(mi_result);
+    GDBWIRE_ASSERT(out);
+
+    *out = 0;
+
+    GDBWIRE_ASSERT(mi_result->kind == GDBWIRE_MI_TUPLE);
+    GDBWIRE_ASSERT(!mi_result->variable ||
+        strcmp(mi_result->variable, "bkpt") == 0);
+
+    result = break_info_for_breakpoint(mi_result->variant.result, &breakpoint);
+    if (result != GDBWIRE_OK) {
+        return result;
+    }
+
+    /**
+     * The locations of a multiple location breakpoint follow the
+     * breakpoint without a variable name, as in -break-info,
+     *   bkpt={number="1",...},{number="1.1",...},{number="1.2",...}
+     */
+    for (mi_result = mi_result->next; mi_result; mi_result = mi_result->next) {
+        GDBWIRE_ASSERT_GOTO(
+            mi_result->kind == GDBWIRE_MI_TUPLE, result, cleanup);
+
+        result = break_info_for_breakpoint(mi_result->variant.result, &bkpt);
+        if (result != GDBWIRE_OK) {
+            goto cleanup;
+        }
+
+        bkpt->multi_breakpoint = breakpoint;
+        if (last) {
+            last->next = bkpt;
+        } else {
+            breakpoint->multi_breakpoints = bkpt;
+        }
+        last = bkpt;
+    }
+
+    mi_command = calloc(1, sizeof(struct gdbwire_mi_command));
+    if (!mi_command) {
+        result = GDBWIRE_NOMEM;
+        goto cleanup;
+    }
+    mi_command->kind = GDBWIRE_MI_BREAK_INFO;
+    mi_command->variant.break_info.breakpoints = breakpoint;
+
+    *out = mi_command;
+
+    return result;
+
+cleanup:
+    gdbwire_mi_breakpoints_free(breakpoint);
+    return result;
+}
+
+/* The fields of a frame tuple */
+enum gdbwire_mi_frame_field {
+    GDBWIRE_MI_FRAME_LEVEL,
+    GDBWIRE_MI_FRAME_ADDR,
+    GDBWIRE_MI_FRAME_FUNC,
+    GDBWIRE_MI_FRAME_FILE,
+    GDBWIRE_MI_FRAME_FULLNAME,
+    GDBWIRE_MI_FRAME_LINE,
+    GDBWIRE_MI_FRAME_FROM,
+    GDBWIRE_MI_FRAME_FIELDS
+};
+
+static const char *const gdbwire_mi_frame_fields[] = {
+    "level",
+    "addr",
+    "func",
+    "file",
+    "fullname",
+    "line",
+    "from"
+};
+
+static struct gdbwire_mi_schema gdbwire_mi_frame_schema =
+    GDBWIRE_MI_SCHEMA(gdbwire_mi_frame_fields);
+
 /**
  * Handle the -stack-info-frame command.
  *
@@ -3051,8 +4874,8 @@ stack_info_frame(
     struct gdbwire_mi_result *mi_result;
     struct gdbwire_mi_command *mi_command = 0;
 
-    char *level = 0, *address = 0;
-    char *func = 0, *file = 0, *fullname = 0, *line = 0, *from = 0;
+    char *fields[GDBWIRE_MI_FRAME_FIELDS];
+    char *level, *address, *func, *file, *fullname, *line, *from;
 
     *out = 0;
 
@@ -3067,27 +4890,15 @@ stack_info_frame(
     GDBWIRE_ASSERT(!mi_result->next);
     mi_result = mi_result->variant.result;
 
-    while (mi_result) {
-        if (mi_result->kind == GDBWIRE_MI_CSTRING) {
-            if (strcmp(mi_result->variable, "level") == 0) {
-                level = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "addr") == 0) {
-                address = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "func") == 0) {
-                func = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "file") == 0) {
-                file = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "fullname") == 0) {
-                fullname = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "line") == 0) {
-                line = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "from") == 0) {
-                from = mi_result->variant.cstring;
-            }
-        }
+    gdbwire_mi_schema_extract(&gdbwire_mi_frame_schema, mi_result, fields);
 
-        mi_result = mi_result->next;
-    }
+    level = fields[GDBWIRE_MI_FRAME_LEVEL];
+    address = fields[GDBWIRE_MI_FRAME_ADDR];
+    func = fields[GDBWIRE_MI_FRAME_FUNC];
+    file = fields[GDBWIRE_MI_FRAME_FILE];
+    fullname = fields[GDBWIRE_MI_FRAME_FULLNAME];
+    line = fields[GDBWIRE_MI_FRAME_LINE];
+    from = fields[GDBWIRE_MI_FRAME_FROM];
 
     GDBWIRE_ASSERT(level && address);
 
@@ -3131,6 +4942,27 @@ stack_info_frame(
     return GDBWIRE_OK;
 }
 
+/* The fields of a source file tuple */
+enum gdbwire_mi_source_file_field {
+    GDBWIRE_MI_SOURCE_FILE_LINE,
+    GDBWIRE_MI_SOURCE_FILE_FILE,
+    GDBWIRE_MI_SOURCE_FILE_FULLNAME,
+    GDBWIRE_MI_SOURCE_FILE_MACRO_INFO,
+    GDBWIRE_MI_SOURCE_FILE_DEBUG_FULLY_READ,
+    GDBWIRE_MI_SOURCE_FILE_FIELDS
+};
+
+static const char *const gdbwire_mi_source_file_fields[] = {
+    "line",
+    "file",
+    "fullname",
+    "macro-info",
+    "debug-fully-read"
+};
+
+static struct gdbwire_mi_schema gdbwire_mi_source_file_schema =
+    GDBWIRE_MI_SCHEMA(gdbwire_mi_source_file_fields);
+
 /**
  * Handle the -file-list-exec-source-file command.
  *
@@ -3151,7 +4983,8 @@ file_list_exec_source_file(
     struct gdbwire_mi_result *mi_result;
     struct gdbwire_mi_command *mi_command = 0;
 
-    char *line = 0, *file = 0, *fullname = 0, *macro_info = 0;
+    char *fields[GDBWIRE_MI_SOURCE_FILE_FIELDS];
+    char *line, *file, *fullname, *macro_info;
 
     *out = 0;
 
@@ -3160,22 +4993,17 @@ file_list_exec_source_file(
 
     mi_result = result_record->result;
 
-    while (mi_result) {
-        if (mi_result->kind == GDBWIRE_MI_CSTRING) {
-            if (strcmp(mi_result->variable, "line") == 0) {
-                line = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "file") == 0) {
-                file = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "fullname") == 0) {
-                fullname = mi_result->variant.cstring;
-            } else if (strcmp(mi_result->variable, "macro-info") == 0) {
-                macro_info = mi_result->variant.cstring;
-                GDBWIRE_ASSERT(strlen(macro_info) == 1);
-                GDBWIRE_ASSERT(macro_info[0] == '0' || macro_info[0] == '1');
-            }
-        }
+    gdbwire_mi_schema_extract(&gdbwire_mi_source_file_schema,
+        mi_result, fields);
 
-        mi_result = mi_result->next;
+    line = fields[GDBWIRE_MI_SOURCE_FILE_LINE];
+    file = fields[GDBWIRE_MI_SOURCE_FILE_FILE];
+    fullname = fields[GDBWIRE_MI_SOURCE_FILE_FULLNAME];
+    macro_info = fields[GDBWIRE_MI_SOURCE_FILE_MACRO_INFO];
+
+    if (macro_info) {
+        GDBWIRE_ASSERT(strlen(macro_info) == 1);
+        GDBWIRE_ASSERT(macro_info[0] == '0' || macro_info[0] == '1');
     }
 
     GDBWIRE_ASSERT(line && file);
@@ -3244,32 +5072,27 @@ file_list_exec_source_files(
     mi_result = mi_result->variant.result;
 
     while (mi_result) {
-        struct gdbwire_mi_result *tuple;
-        char *file = 0, *fullname = 0;
+        char *fields[GDBWIRE_MI_SOURCE_FILE_FIELDS];
+        char *file, *fullname, *fully_read;
         enum gdbwire_mi_debug_fully_read_kind debug_fully_read =
             GDBWIRE_MI_DEBUG_FULLY_READ_UNKNOWN;
         GDBWIRE_ASSERT_GOTO(mi_result->kind == GDBWIRE_MI_TUPLE, result, err);
-        tuple = mi_result->variant.result;
-
-        while (tuple) {
-            /* file field */
-            GDBWIRE_ASSERT_GOTO(tuple->kind == GDBWIRE_MI_CSTRING, result, err);
-
-            if (strcmp(tuple->variable, "file") == 0) {
-                file = tuple->variant.cstring;
-            } else if (strcmp(tuple->variable, "fullname") == 0) {
-                fullname = tuple->variant.cstring;
-            } else if (strcmp(tuple->variable, "debug-fully-read") == 0) {
-                if (strcmp(tuple->variant.cstring, "false") == 0) {
-                    debug_fully_read =
-                        GDBWIRE_MI_DEBUG_FULLY_READ_FALSE;
-                } else if (strcmp(tuple->variant.cstring, "true") == 0) {
-                    debug_fully_read =
-                        GDBWIRE_MI_DEBUG_FULLY_READ_TRUE;
-                }
-            }
 
-            tuple = tuple->next;
+        /* Every field of a source file is a cstring */
+        GDBWIRE_ASSERT_GOTO(gdbwire_mi_schema_extract(
+            &gdbwire_mi_source_file_schema, mi_result->variant.result,
+            fields) == 0, result, err);
+
+        file = fields[GDBWIRE_MI_SOURCE_FILE_FILE];
+        fullname = fields[GDBWIRE_MI_SOURCE_FILE_FULLNAME];
+        fully_read = fields[GDBWIRE_MI_SOURCE_FILE_DEBUG_FULLY_READ];
+
+        if (fully_read) {
+            if (strcmp(fully_read, "false") == 0) {
+                debug_fully_read = GDBWIRE_MI_DEBUG_FULLY_READ_FALSE;
+            } else if (strcmp(fully_read, "true") == 0) {
+                debug_fully_read = GDBWIRE_MI_DEBUG_FULLY_READ_TRUE;
+            }
         }
 
         // file is required, but fullname and debug_fully_read is not
@@ -3856,7 +5679,7 @@ static yyconst flex_int16_t yy_chk[67] =
 #define YY_USER_ACTION \
     { \
     struct gdbwire_mi_position pos = { yycolumn, yycolumn+yyleng-1 }; \
-    yyextra = pos; \
+    yyextra.pos = pos; \
     yycolumn += yyleng; \
     }
 
@@ -3870,7 +5693,7 @@ static yyconst flex_int16_t yy_chk[67] =
 #include <unistd.h>
 #endif
 
-#define YY_EXTRA_TYPE struct gdbwire_mi_position
+#define YY_EXTRA_TYPE struct gdbwire_mi_lexer_extra
 
 /* Holds the entire state of the reentrant scanner. */
 struct yyguts_t
@@ -5483,7 +7306,21 @@ void gdbwire_mi_free (void * ptr , yyscan_t yyscanner)
 /* #include "gdbwire_mi_pt_alloc.h" */
 
 char *gdbwire_mi_get_text(yyscan_t yyscanner);
-struct gdbwire_mi_position gdbwire_mi_get_extra(yyscan_t yyscanner);
+struct gdbwire_mi_lexer_extra gdbwire_mi_get_extra(yyscan_t yyscanner);
+
+/**
+ * Get the arena the parse tree of the current line is allocated from.
+ *
+ * @param yyscanner
+ * The lexer the grammar is reading tokens from.
+ *
+ * @return
+ * The arena, never NULL while a line is being parsed.
+ */
+static struct gdbwire_mi_arena *gdbwire_mi_get_arena(yyscan_t yyscanner)
+{
+    return gdbwire_mi_get_extra(yyscanner).arena;
+}
 
 /**
  * Used only in the parser to build a gdbwire_mi_result list.
@@ -5505,13 +7342,18 @@ struct gdbwire_mi_result_list {
 /** 
  * Allocate a gdbwire_mi_result_list data structure.
  *
+ * @param arena
+ * The arena to allocate the list from.
+ *
  * @return
- * The gdbwire_mi_result_list. Use free() to release the memory.
+ * The gdbwire_mi_result_list. It is released with the arena.
  */
-struct gdbwire_mi_result_list *gdbwire_mi_result_list_alloc(void)
+struct gdbwire_mi_result_list *gdbwire_mi_result_list_alloc(
+        struct gdbwire_mi_arena *arena)
 {
     struct gdbwire_mi_result_list *result;
-    result = calloc(1, sizeof(struct gdbwire_mi_result_list));
+    result = gdbwire_mi_arena_alloc(arena,
+            sizeof(struct gdbwire_mi_result_list));
     result->tail = &result->head;
     return result;
 }
@@ -5536,102 +7378,13 @@ void gdbwire_mi_error(yyscan_t yyscanner,
     struct gdbwire_mi_output **gdbwire_mi_output, const char *s)
 { 
     char *text = gdbwire_mi_get_text(yyscanner);
-    struct gdbwire_mi_position pos = gdbwire_mi_get_extra(yyscanner);
+    struct gdbwire_mi_lexer_extra extra = gdbwire_mi_get_extra(yyscanner);
 
-    *gdbwire_mi_output = gdbwire_mi_output_alloc();
+    *gdbwire_mi_output = gdbwire_mi_output_alloc(extra.arena);
     (*gdbwire_mi_output)->kind = GDBWIRE_MI_OUTPUT_PARSE_ERROR;
-    (*gdbwire_mi_output)->variant.error.token = gdbwire_strdup(text);
-    (*gdbwire_mi_output)->variant.error.pos = pos;
-}
-
-/**
- * GDB/MI escapes characters in the c-string rule.
- *
- * The c-string starts and ends with a ".
- * Each " in the c-string is escaped with a \. So GDB turns " into \".
- * Each \ in the string is then escaped with a \. So GDB turns \ into \\.
- *
- * Remove the GDB/MI escape characters to provide back to the user the
- * original characters that GDB was intending to transmit. So
- *   \" -> "
- *   \\ -> \
- *   \n -> new line
- *   \r -> carriage return
- *   \t -> tab
- *
- * See gdbwire_mi_grammar.txt (GDB/MI Clarifications) for more information.
- *
- * @param str
- * The escaped GDB/MI c-string data.
- *
- * @return
- * An allocated strng representing str with the escaping undone.
- */
-static char *gdbwire_mi_unescape_cstring(char *str)
-{
-    char *result;
-    size_t r, s, length;
-
-    /*assert(str);*/
-
-    result = gdbwire_strdup(str);
-    length = strlen(str);
-
-    /* a CSTRING should start and end with a quote */
-    /*assert(result);*/
-    /*assert(length >= 2);*/
-
-    for (r = 0, s = 1; s < length - 1; ++s) {
-        if (str[s] == '\\') {
-            switch (str[s+1]) {
-                case 'n':
-                    result[r++] = '\n';
-                    ++s;
-                    break;
-                case 'b':
-                    result[r++] = '\b';
-                    ++s;
-                    break;
-                case 't':
-                    result[r++] = '\t';
-                    ++s;
-                    break;
-                case 'f':
-                    result[r++] = '\f';
-                    ++s;
-                    break;
-                case 'r':
-                    result[r++] = '\r';
-                    ++s;
-                    break;
-                case 'e':
-                    result[r++] = '\033';
-                    ++s;
-                    break;
-                case 'a':
-                    result[r++] = '\007';
-                    ++s;
-                    break;
-                case '"':
-                    result[r++] = '\"';
-                    ++s;
-                    break;
-                case '\\':
-                    result[r++] = '\\';
-                    ++s;
-                    break;
-                default:
-                    result[r++] = str[s];
-                    break;
-            }
-        } else {
-            result[r++] = str[s];
-        }
-    }
-
-    result[r] = 0;
-
-    return result;
+    (*gdbwire_mi_output)->variant.error.token =
+        gdbwire_mi_arena_strndup(extra.arena, text, strlen(text));
+    (*gdbwire_mi_output)->variant.error.pos = extra.pos;
 }
 
 
@@ -6604,36 +8357,7 @@ yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, yyscan_t yyscanner
   YY_SYMBOL_PRINT (yymsg, yytype, yyvaluep, yylocationp);
 
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
-  switch (yytype)
-    {
-          case 24: /* output_variant  */
-      { gdbwire_mi_output_free(((*yyvaluep).u_output)); }
-        break;
-
-    case 32: /* opt_variable  */
-      { free(((*yyvaluep).u_variable)); }
-        break;
-
-    case 33: /* result_list  */
-      { gdbwire_mi_result_free(((*yyvaluep).u_result_list)->head); free(((*yyvaluep).u_result_list)); }
-        break;
-
-    case 34: /* result  */
-      { gdbwire_mi_result_free(((*yyvaluep).u_result)); }
-        break;
-
-    case 35: /* variable  */
-      { free(((*yyvaluep).u_variable)); }
-        break;
-
-    case 41: /* opt_token  */
-      { free(((*yyvaluep).u_token)); }
-        break;
-
-
-      default:
-        break;
-    }
+  YYUSE (yytype);
   YY_IGNORE_MAYBE_UNINITIALIZED_END
 }
 
@@ -6973,7 +8697,7 @@ yyreduce:
 
   case 6:
     {
-  (yyval.u_output) = gdbwire_mi_output_alloc();
+  (yyval.u_output) = gdbwire_mi_output_alloc(gdbwire_mi_get_arena(yyscanner));
   (yyval.u_output)->kind = GDBWIRE_MI_OUTPUT_OOB;
   (yyval.u_output)->variant.oob_record = (yyvsp[0].u_oob_record);
 }
@@ -6981,7 +8705,7 @@ yyreduce:
 
   case 7:
     {
-  (yyval.u_output) = gdbwire_mi_output_alloc();
+  (yyval.u_output) = gdbwire_mi_output_alloc(gdbwire_mi_get_arena(yyscanner));
   (yyval.u_output)->kind = GDBWIRE_MI_OUTPUT_RESULT;
   (yyval.u_output)->variant.result_record = (yyvsp[0].u_result_record);
 }
@@ -6990,7 +8714,6 @@ yyreduce:
   case 8:
     {
       if (strcmp("gdb", (yyvsp[0].u_variable)) != 0) {
-          /* Destructor will be called to free $2 on error */
           yyerror(yyscanner, gdbwire_mi_output, "");
           YYERROR;
       }
@@ -6999,15 +8722,14 @@ yyreduce:
 
   case 9:
     {
-      (yyval.u_output) = gdbwire_mi_output_alloc();
+      (yyval.u_output) = gdbwire_mi_output_alloc(gdbwire_mi_get_arena(yyscanner));
       (yyval.u_output)->kind = GDBWIRE_MI_OUTPUT_PROMPT;
-      free((yyvsp[-2].u_variable));
     }
     break;
 
   case 10:
     {
-  (yyval.u_result_record) = gdbwire_mi_result_record_alloc();
+  (yyval.u_result_record) = gdbwire_mi_result_record_alloc(gdbwire_mi_get_arena(yyscanner));
   (yyval.u_result_record)->token = (yyvsp[-2].u_token);
   (yyval.u_result_record)->result_class = (yyvsp[0].u_result_class);
   (yyval.u_result_record)->result = NULL;
@@ -7016,17 +8738,16 @@ yyreduce:
 
   case 11:
     {
-  (yyval.u_result_record) = gdbwire_mi_result_record_alloc();
+  (yyval.u_result_record) = gdbwire_mi_result_record_alloc(gdbwire_mi_get_arena(yyscanner));
   (yyval.u_result_record)->token = (yyvsp[-4].u_token);
   (yyval.u_result_record)->result_class = (yyvsp[-2].u_result_class);
   (yyval.u_result_record)->result = (yyvsp[0].u_result_list)->head;
-  free((yyvsp[0].u_result_list));
 }
     break;
 
   case 12:
     {
-  (yyval.u_oob_record) = gdbwire_mi_oob_record_alloc();
+  (yyval.u_oob_record) = gdbwire_mi_oob_record_alloc(gdbwire_mi_get_arena(yyscanner));
   (yyval.u_oob_record)->kind = GDBWIRE_MI_ASYNC;
   (yyval.u_oob_record)->variant.async_record = (yyvsp[0].u_async_record);
 }
@@ -7034,7 +8755,7 @@ yyreduce:
 
   case 13:
     {
-  (yyval.u_oob_record) = gdbwire_mi_oob_record_alloc();
+  (yyval.u_oob_record) = gdbwire_mi_oob_record_alloc(gdbwire_mi_get_arena(yyscanner));
   (yyval.u_oob_record)->kind = GDBWIRE_MI_STREAM;
   (yyval.u_oob_record)->variant.stream_record = (yyvsp[0].u_stream_record);
 }
@@ -7042,7 +8763,7 @@ yyreduce:
 
   case 14:
     {
-  (yyval.u_async_record) = gdbwire_mi_async_record_alloc();
+  (yyval.u_async_record) = gdbwire_mi_async_record_alloc(gdbwire_mi_get_arena(yyscanner));
   (yyval.u_async_record)->token = (yyvsp[-2].u_token);
   (yyval.u_async_record)->kind = (yyvsp[-1].u_async_record_kind);
   (yyval.u_async_record)->async_class = (yyvsp[0].u_async_class);
@@ -7052,12 +8773,11 @@ yyreduce:
 
   case 15:
     {
-  (yyval.u_async_record) = gdbwire_mi_async_record_alloc();
+  (yyval.u_async_record) = gdbwire_mi_async_record_alloc(gdbwire_mi_get_arena(yyscanner));
   (yyval.u_async_record)->token = (yyvsp[-4].u_token);
   (yyval.u_async_record)->kind = (yyvsp[-3].u_async_record_kind);
   (yyval.u_async_record)->async_class = (yyvsp[-2].u_async_class);
   (yyval.u_async_record)->result = (yyvsp[0].u_result_list)->head;
-  free((yyvsp[0].u_result_list));
 }
     break;
 
@@ -7167,7 +8887,7 @@ yyreduce:
 
   case 23:
     {
-  (yyval.u_result_list) = gdbwire_mi_result_list_alloc();
+  (yyval.u_result_list) = gdbwire_mi_result_list_alloc(gdbwire_mi_get_arena(yyscanner));
   gdbwire_mi_result_list_push_back((yyval.u_result_list), (yyvsp[0].u_result));
 }
     break;
@@ -7181,7 +8901,7 @@ yyreduce:
 
   case 25:
     {
-  (yyval.u_result) = gdbwire_mi_result_alloc();
+  (yyval.u_result) = gdbwire_mi_result_alloc(gdbwire_mi_get_arena(yyscanner));
   (yyval.u_result)->variable = (yyvsp[-1].u_variable);
   (yyval.u_result)->kind = GDBWIRE_MI_CSTRING;
   (yyval.u_result)->variant.cstring = (yyvsp[0].u_cstring);
@@ -7190,7 +8910,7 @@ yyreduce:
 
   case 26:
     {
-  (yyval.u_result) = gdbwire_mi_result_alloc();
+  (yyval.u_result) = gdbwire_mi_result_alloc(gdbwire_mi_get_arena(yyscanner));
   (yyval.u_result)->variable = (yyvsp[-1].u_variable);
   (yyval.u_result)->kind = GDBWIRE_MI_TUPLE;
   (yyval.u_result)->variant.result = (yyvsp[0].u_tuple);
@@ -7199,7 +8919,7 @@ yyreduce:
 
   case 27:
     {
-  (yyval.u_result) = gdbwire_mi_result_alloc();
+  (yyval.u_result) = gdbwire_mi_result_alloc(gdbwire_mi_get_arena(yyscanner));
   (yyval.u_result)->variable = (yyvsp[-1].u_variable);
   (yyval.u_result)->kind = GDBWIRE_MI_LIST;
   (yyval.u_result)->variant.result = (yyvsp[0].u_list);
@@ -7209,14 +8929,16 @@ yyreduce:
   case 28:
     {
   char *text = gdbwire_mi_get_text(yyscanner);
-  (yyval.u_variable) = gdbwire_strdup(text);
+  (yyval.u_variable) = gdbwire_mi_arena_strndup(
+      gdbwire_mi_get_arena(yyscanner), text, strlen(text));
 }
     break;
 
   case 29:
     {
   char *text = gdbwire_mi_get_text(yyscanner);
-  (yyval.u_cstring) = gdbwire_mi_unescape_cstring(text);
+  (yyval.u_cstring) = gdbwire_mi_arena_unescape(
+      gdbwire_mi_get_arena(yyscanner), text, strlen(text));
 }
     break;
 
@@ -7229,7 +8951,6 @@ yyreduce:
   case 31:
     {
   (yyval.u_tuple) = (yyvsp[-1].u_result_list)->head;
-  free((yyvsp[-1].u_result_list));
 }
     break;
 
@@ -7242,13 +8963,12 @@ yyreduce:
   case 33:
     {
   (yyval.u_list) = (yyvsp[-1].u_result_list)->head;
-  free((yyvsp[-1].u_result_list));
 }
     break;
 
   case 34:
     {
-  (yyval.u_stream_record) = gdbwire_mi_stream_record_alloc();
+  (yyval.u_stream_record) = gdbwire_mi_stream_record_alloc(gdbwire_mi_get_arena(yyscanner));
   (yyval.u_stream_record)->kind = (yyvsp[-1].u_stream_record_kind);
   (yyval.u_stream_record)->cstring = (yyvsp[0].u_cstring);
 }
@@ -7287,7 +9007,8 @@ yyreduce:
   case 40:
     {
   char *text = gdbwire_mi_get_text(yyscanner);
-  (yyval.u_token) = gdbwire_strdup(text);
+  (yyval.u_token) = gdbwire_mi_arena_strndup(
+      gdbwire_mi_get_arena(yyscanner), text, strlen(text));
 }
     break;
 
@@ -7722,6 +9443,69 @@ void gdbwire_destroy(struct gdbwire *wire);
 enum gdbwire_result gdbwire_push_data(struct gdbwire *wire, const char *data,
         size_t size);
 
+/**
+ * Hand the elements of a list to a callback as they are parsed.
+ *
+ * See gdbwire_mi_parser_stream_list.
+ *
+ * @param wire
+ * The gdbwire context to operate on.
+ *
+ * @param path
+ * The variables leading to the list from the result record, separated
+ * by periods.
+ *
+ * @param callback
+ * Called with each element of the list.
+ *
+ * @param context
+ * Passed to the callback.
+ *
+ * @return
+ * GDBWIRE_OK on success or GDBWIRE_NOMEM if out of memory.
+ */
+enum gdbwire_result gdbwire_stream_list(struct gdbwire *wire,
+        const char *path,
+        void (*callback)(void *context, const char *token,
+            struct gdbwire_mi_result *element),
+        void *context);
+
+/**
+ * Set how much of the async records of a class gdbwire parses.
+ *
+ * See gdbwire_mi_parser_set_async_interest.
+ *
+ * @param wire
+ * The gdbwire context to operate on.
+ *
+ * @param async_class
+ * The async class.
+ *
+ * @param interest
+ * How much of the records to parse.
+ */
+void gdbwire_set_async_interest(struct gdbwire *wire,
+        enum gdbwire_mi_async_class async_class,
+        enum gdbwire_mi_interest interest);
+
+/**
+ * Set how much of the stream records of a kind gdbwire parses.
+ *
+ * See gdbwire_mi_parser_set_stream_interest.
+ *
+ * @param wire
+ * The gdbwire context to operate on.
+ *
+ * @param kind
+ * The kind of stream record.
+ *
+ * @param interest
+ * How much of the records to parse.
+ */
+void gdbwire_set_stream_interest(struct gdbwire *wire,
+        enum gdbwire_mi_stream_record_kind kind,
+        enum gdbwire_mi_interest interest);
+
 /**
  * Handle an interpreter-exec command.
  *
@@ -7873,6 +9657,38 @@ gdbwire_push_data(struct gdbwire *wire, const char *data, size_t size)
     return result;
 }
 
+enum gdbwire_result
+gdbwire_stream_list(struct gdbwire *wire, const char *path,
+        void (*callback)(void *context, const char *token,
+            struct gdbwire_mi_result *element),
+        void *context)
+{
+    GDBWIRE_ASSERT(wire);
+    return gdbwire_mi_parser_stream_list(wire->parser, path, callback,
+        context);
+}
+
+void
+gdbwire_set_async_interest(struct gdbwire *wire,
+        enum gdbwire_mi_async_class async_class,
+        enum gdbwire_mi_interest interest)
+{
+    if (wire) {
+        gdbwire_mi_parser_set_async_interest(wire->parser, async_class,
+            interest);
+    }
+}
+
+void
+gdbwire_set_stream_interest(struct gdbwire *wire,
+        enum gdbwire_mi_stream_record_kind kind,
+        enum gdbwire_mi_interest interest)
+{
+    if (wire) {
+        gdbwire_mi_parser_set_stream_interest(wire->parser, kind, interest);
+    }
+}
+
 struct gdbwire_interpreter_exec_context {
     enum gdbwire_result result;
     enum gdbwire_mi_command_kind kind;
@@ -633,12 +633,21 @@ struct gdbwire_mi_output {
      * MI output from GDB. This field represents the line that created 
      * this particular output structure.
      *
-     * This field is always available and never NULL, even for a parse error.
+     * Copying every line is wasted work for most front ends, so this
+     * field is only set for prompts and parse errors, unless the parser
+     * was asked to keep every line with gdbwire_mi_parser_keep_lines.
+     * Otherwise it is NULL.
      */
     char *line;
 
     /** The next GDB/MI output command or NULL if none */
     struct gdbwire_mi_output *next;
+
+    /**
+     * The memory this output and everything it refers to was allocated
+     * from. It is released by gdbwire_mi_output_free.
+     */
+    struct gdbwire_mi_arena *arena;
 };
 
 /**
@@ -1223,31 +1232,152 @@ extern "C" {
 
 /**
  * Responsible for allocating and deallocating gdbwire_mi_pt objects.
+ *
+ * Every object in the parse tree of a GDB/MI line, including its strings,
+ * is allocated from one arena. The arena is handed to the
+ * gdbwire_mi_output created for the line, and gdbwire_mi_output_free
+ * releases the whole tree at once.
+ */
+
+/* The memory the parse tree of a GDB/MI line is allocated from */
+struct gdbwire_mi_arena;
+
+/**
+ * Create an arena.
+ *
+ * @param size
+ * The number of bytes the arena is expected to hold. The arena grows
+ * past this if needed.
+ *
+ * @return
+ * The new arena or NULL if out of memory.
+ */
+struct gdbwire_mi_arena *gdbwire_mi_arena_create(size_t size);
+
+/**
+ * Free an arena and everything allocated from it.
+ *
+ * @param arena
+ * The arena to free, may be NULL.
+ */
+void gdbwire_mi_arena_destroy(struct gdbwire_mi_arena *arena);
+
+/* A block of memory an arena hands out allocations from */
+struct gdbwire_mi_arena_block;
+
+/**
+ * A point in an arena's allocations.
+ *
+ * Releasing an arena back to a mark frees everything allocated since,
+ * so a parser can reuse the memory of a subtree it is done with.
+ */
+struct gdbwire_mi_arena_mark {
+    /* The arena's newest block when the mark was made */
+    struct gdbwire_mi_arena_block *block;
+    /* The number of bytes of that block handed out at the time */
+    size_t used;
+};
+
+/**
+ * Remember the current point in an arena's allocations.
+ *
+ * @param arena
+ * The arena to mark.
+ *
+ * @param mark
+ * Set to the current point.
+ */
+void gdbwire_mi_arena_mark(struct gdbwire_mi_arena *arena,
+        struct gdbwire_mi_arena_mark *mark);
+
+/**
+ * Free everything allocated from an arena since a mark.
+ *
+ * @param arena
+ * The arena to release memory from.
+ *
+ * @param mark
+ * A mark made on the arena, with no release to an earlier mark since.
+ */
+void gdbwire_mi_arena_release(struct gdbwire_mi_arena *arena,
+        const struct gdbwire_mi_arena_mark *mark);
+
+/**
+ * Allocate zeroed memory from an arena.
+ *
+ * @param arena
+ * The arena to allocate from.
+ *
+ * @param size
+ * The number of bytes to allocate.
+ *
+ * @return
+ * The memory, suitably aligned for any parse tree object,
+ * or NULL if out of memory.
+ */
+void *gdbwire_mi_arena_alloc(struct gdbwire_mi_arena *arena, size_t size);
+
+/**
+ * Copy data into an arena as a null terminated string.
+ *
+ * @param arena
+ * The arena to allocate from.
+ *
+ * @param str
+ * The data to copy, it does not need to be null terminated.
+ *
+ * @param size
+ * The number of bytes to copy.
+ *
+ * @return
+ * The string or NULL if out of memory.
+ */
+char *gdbwire_mi_arena_strndup(struct gdbwire_mi_arena *arena,
+        const char *str, size_t size);
+
+/**
+ * Copy a GDB/MI c-string into an arena with its escaping undone.
+ *
+ * @param arena
+ * The arena to allocate from.
+ *
+ * @param str
+ * The c-string as GDB sent it, including the surrounding quotes.
+ * It does not need to be null terminated.
+ *
+ * @param length
+ * The number of bytes in str, at least 2.
+ *
+ * @return
+ * The unescaped string or NULL if out of memory.
  */
+char *gdbwire_mi_arena_unescape(struct gdbwire_mi_arena *arena,
+        const char *str, size_t length);
 
 /* struct gdbwire_mi_output */
-struct gdbwire_mi_output *gdbwire_mi_output_alloc(void);
+struct gdbwire_mi_output *gdbwire_mi_output_alloc(
+        struct gdbwire_mi_arena *arena);
 void gdbwire_mi_output_free(struct gdbwire_mi_output *param);
 
 /* struct gdbwire_mi_result_record */
-struct gdbwire_mi_result_record *gdbwire_mi_result_record_alloc(void);
-void gdbwire_mi_result_record_free(struct gdbwire_mi_result_record *param);
+struct gdbwire_mi_result_record *gdbwire_mi_result_record_alloc(
+        struct gdbwire_mi_arena *arena);
 
 /* struct gdbwire_mi_result */
-struct gdbwire_mi_result *gdbwire_mi_result_alloc(void);
-void gdbwire_mi_result_free(struct gdbwire_mi_result *param);
+struct gdbwire_mi_result *gdbwire_mi_result_alloc(
+        struct gdbwire_mi_arena *arena);
 
 /* struct gdbwire_mi_oob_record */
-struct gdbwire_mi_oob_record *gdbwire_mi_oob_record_alloc(void);
-void gdbwire_mi_oob_record_free(struct gdbwire_mi_oob_record *param);
+struct gdbwire_mi_oob_record *gdbwire_mi_oob_record_alloc(
+        struct gdbwire_mi_arena *arena);
 
 /* struct gdbwire_mi_async_record */
-struct gdbwire_mi_async_record *gdbwire_mi_async_record_alloc(void);
-void gdbwire_mi_async_record_free(struct gdbwire_mi_async_record *param);
+struct gdbwire_mi_async_record *gdbwire_mi_async_record_alloc(
+        struct gdbwire_mi_arena *arena);
 
 /* struct gdbwire_mi_stream_record */
-struct gdbwire_mi_stream_record *gdbwire_mi_stream_record_alloc(void);
-void gdbwire_mi_stream_record_free(struct gdbwire_mi_stream_record *param);
+struct gdbwire_mi_stream_record *gdbwire_mi_stream_record_alloc(
+        struct gdbwire_mi_arena *arena);
 
 #ifdef __cplusplus 
 }
@@ -1354,12 +1484,21 @@ struct gdbwire_mi_output {
      * MI output from GDB. This field represents the line that created 
      * this particular output structure.
      *
-     * This field is always available and never NULL, even for a parse error.
+     * Copying every line is wasted work for most front ends, so this
+     * field is only set for prompts and parse errors, unless the parser
+     * was asked to keep every line with gdbwire_mi_parser_keep_lines.
+     * Otherwise it is NULL.
      */
     char *line;
 
     /** The next GDB/MI output command or NULL if none */
     struct gdbwire_mi_output *next;
+
+    /**
+     * The memory this output and everything it refers to was allocated
+     * from. It is released by gdbwire_mi_output_free.
+     */
+    struct gdbwire_mi_arena *arena;
 };
 
 /**
@@ -2033,6 +2172,134 @@ enum gdbwire_result gdbwire_mi_parser_push(struct gdbwire_mi_parser *parser,
 enum gdbwire_result gdbwire_mi_parser_push_data(
         struct gdbwire_mi_parser *parser, const char *data, size_t size);
 
+/**
+ * Choose whether every output command keeps the line it was parsed from.
+ *
+ * By default only prompts and parse errors set gdbwire_mi_output::line.
+ *
+ * @param parser
+ * The gdbwire_mi parser context to operate on.
+ *
+ * @param keep
+ * Non-zero to set gdbwire_mi_output::line for every output command.
+ */
+void gdbwire_mi_parser_keep_lines(struct gdbwire_mi_parser *parser, int keep);
+
+/**
+ * Choose whether lines are parsed by the hand written parser first.
+ *
+ * The hand written parser is faster and produces the same output
+ * commands as the grammar, which parses any line it does not accept.
+ * It is used by default.
+ *
+ * @param parser
+ * The gdbwire_mi parser context to operate on.
+ *
+ * @param use
+ * Non-zero to use the hand written parser, zero for only the grammar.
+ */
+void gdbwire_mi_parser_use_fast_path(struct gdbwire_mi_parser *parser,
+        int use);
+
+/**
+ * Hand the elements of a list to a callback as they are parsed.
+ *
+ * Some result records hold lists with thousands of elements, like the
+ * files of -file-list-exec-source-files or the body of the -break-info
+ * table. Streaming such a list lets the front end convert each element
+ * while the parser reuses the memory of the one before, instead of
+ * building the whole list first.
+ *
+ * A line is only parsed once its newline arrives, so the elements are
+ * handed over after the whole line has been read and the raw line is
+ * held in memory in full. What streaming saves is the parsed copies:
+ * only one element of the list is kept as parsed results at a time.
+ *
+ * The elements of a streamed list are handed over before the result
+ * record holding the list is delivered, and the list is left empty in
+ * the record. If the line turns out not to be valid GDB/MI, some of its
+ * elements may have been handed over without a result record following.
+ *
+ * @param parser
+ * The gdbwire_mi parser context to operate on.
+ *
+ * @param path
+ * The variables leading to the list from the result record, separated
+ * by periods. For example, "files" or "BreakpointTable.body".
+ *
+ * @param callback
+ * Called with each element of the list. The token is the token of the
+ * result record, or NULL if it has none. The element is freed when the
+ * callback returns.
+ *
+ * @param context
+ * Passed to the callback.
+ *
+ * @return
+ * GDBWIRE_OK on success or GDBWIRE_NOMEM if out of memory.
+ */
+enum gdbwire_result gdbwire_mi_parser_stream_list(
+        struct gdbwire_mi_parser *parser, const char *path,
+        void (*callback)(void *context, const char *token,
+            struct gdbwire_mi_result *element),
+        void *context);
+
+/**
+ * How much of a record the parser builds.
+ *
+ * Front ends usually act on only a few kinds of records. Records they
+ * are not interested in are recognized by their prefix and class, and
+ * skipped or delivered without being parsed.
+ */
+enum gdbwire_mi_interest {
+    /* Parse the record fully, the default for every record */
+    GDBWIRE_MI_INTEREST_FULL,
+
+    /**
+     * Only deliver what kind of record it is.
+     *
+     * An async record has its token, kind and class but no results.
+     * A stream record has its kind but a NULL cstring.
+     */
+    GDBWIRE_MI_INTEREST_CLASS,
+
+    /* Skip the record, no output command is created for it */
+    GDBWIRE_MI_INTEREST_NONE
+};
+
+/**
+ * Set how much of the async records of a class the parser builds.
+ *
+ * @param parser
+ * The gdbwire_mi parser context to operate on.
+ *
+ * @param async_class
+ * The async class, GDBWIRE_MI_ASYNC_UNSUPPORTED for every class
+ * gdbwire does not know.
+ *
+ * @param interest
+ * How much of the records to build.
+ */
+void gdbwire_mi_parser_set_async_interest(struct gdbwire_mi_parser *parser,
+        enum gdbwire_mi_async_class async_class,
+        enum gdbwire_mi_interest interest);
+
+/**
+ * Set how much of the stream records of a kind the parser builds.
+ *
+ * @param parser
+ * The gdbwire_mi parser context to operate on.
+ *
+ * @param kind
+ * The kind of stream record.
+ *
+ * @param interest
+ * How much of the records to build.
+ */
+void gdbwire_mi_parser_set_stream_interest(struct gdbwire_mi_parser *parser,
+        enum gdbwire_mi_stream_record_kind kind,
+        enum gdbwire_mi_interest interest);
+
 #ifdef __cplusplus 
 }
 #endif 
@@ -2422,6 +2689,91 @@ enum gdbwire_result gdbwire_get_mi_command(
         struct gdbwire_mi_result_record *result_record,
         struct gdbwire_mi_command **out_mi_command);
 
+/**
+ * Get the breakpoint described by a breakpoint async record.
+ *
+ * The =breakpoint-created and =breakpoint-modified async records
+ * describe the breakpoint with the same bkpt tuple that -break-info
+ * uses for each row of its table.
+ *
+ * It also converts the elements of a streamed -break-info body one at
+ * a time. After the first, GDB leaves out the bkpt variable of those.
+ *
+ * @param result
+ * The results of the async record, starting with bkpt={...}. The
+ * locations of a multiple location breakpoint follow it as tuples.
+ *
+ * @param out_mi_command
+ * Will return an allocated GDBWIRE_MI_BREAK_INFO command holding the
+ * single breakpoint if GDBWIRE_OK is returned from this function.
+ * You should free this memory with gdbwire_mi_command_free when you
+ * are done with it.
+ *
+ * @return
+ * The result of this function.
+ */
+enum gdbwire_result gdbwire_get_mi_breakpoint(
+        struct gdbwire_mi_result *result,
+        struct gdbwire_mi_command **out_mi_command);
+
+/**
+ * The number of hash slots in a gdbwire_mi_schema.
+ *
+ * A schema can hold at most half this many fields.
+ */
+#define GDBWIRE_MI_SCHEMA_SLOTS 64
+
+/**
+ * The fields to extract from the results of a tuple.
+ *
+ * Declare a schema once for each kind of tuple, with GDBWIRE_MI_SCHEMA,
+ * and extract the fields with gdbwire_mi_schema_extract. Each result is
+ * then matched to its field with one hash lookup, rather than by
+ * comparing it against every field name in turn.
+ */
+struct gdbwire_mi_schema {
+    /* The names of the fields, in the order their values are extracted */
+    const char *const *names;
+    /* The number of names */
+    size_t count;
+    /* A hash table of the index of each name plus one, 0 if empty */
+    unsigned char slots[GDBWIRE_MI_SCHEMA_SLOTS];
+    /* Non-zero once the hash table has been built */
+    int initialized;
+};
+
+/**
+ * Initialize a gdbwire_mi_schema from an array of field names.
+ *
+ * The hash table is built the first time the schema is used. An array
+ * of more than GDBWIRE_MI_SCHEMA_SLOTS / 2 names does not compile.
+ */
+#define GDBWIRE_MI_SCHEMA(names) \
+    { names, sizeof(names) / sizeof((names)[0]) + 0 * sizeof(char[ \
+        sizeof(names) / sizeof((names)[0]) <= GDBWIRE_MI_SCHEMA_SLOTS / 2 ? \
+        1 : -1]), { 0 }, 0 }
+
+/**
+ * Extract the fields of a schema from the results of a tuple.
+ *
+ * @param schema
+ * The fields to extract.
+ *
+ * @param result
+ * The first result of the tuple.
+ *
+ * @param values
+ * An array of schema->count values. Each is set to the cstring of the
+ * last result named by the field at the same index of the schema,
+ * or NULL if the tuple has no such result. All of them are NULL if the
+ * schema has more than GDBWIRE_MI_SCHEMA_SLOTS / 2 fields.
+ *
+ * @return
+ * The number of results that were not cstrings. These are skipped.
+ */
+size_t gdbwire_mi_schema_extract(struct gdbwire_mi_schema *schema,
+        struct gdbwire_mi_result *result, char **values);
+
 /**
  * Free the gdbwire mi command.
  *
@@ -2995,6 +3347,91 @@ enum gdbwire_result gdbwire_get_mi_command(
         struct gdbwire_mi_result_record *result_record,
         struct gdbwire_mi_command **out_mi_command);
 
+/**
+ * Get the breakpoint described by a breakpoint async record.
+ *
+ * The =breakpoint-created and =breakpoint-modified async records
+ * describe the breakpoint with the same bkpt tuple that -break-info
+ * uses for each row of its table.
+ *
+ * It also converts the elements of a streamed -break-info body one at
+ * a time. After the first, GDB leaves out the bkpt variable of those.
+ *
+ * @param result
+ * The results of the async record, starting with bkpt={...}. The
+ * locations of a multiple location breakpoint follow it as tuples.
+ *
+ * @param out_mi_command
+ * Will return an allocated GDBWIRE_MI_BREAK_INFO command holding the
+ * single breakpoint if GDBWIRE_OK is returned from this function.
+ * You should free this memory with gdbwire_mi_command_free when you
+ * are done with it.
+ *
+ * @return
+ * The result of this function.
+ */
+enum gdbwire_result gdbwire_get_mi_breakpoint(
+        struct gdbwire_mi_result *result,
+        struct gdbwire_mi_command **out_mi_command);
+
+/**
+ * The number of hash slots in a gdbwire_mi_schema.
+ *
+ * A schema can hold at most half this many fields.
+ */
+#define GDBWIRE_MI_SCHEMA_SLOTS 64
+
+/**
+ * The fields to extract from the results of a tuple.
+ *
+ * Declare a schema once for each kind of tuple, with GDBWIRE_MI_SCHEMA,
+ * and extract the fields with gdbwire_mi_schema_extract. Each result is
+ * then matched to its field with one hash lookup, rather than by
+ * comparing it against every field name in turn.
+ */
+struct gdbwire_mi_schema {
+    /* The names of the fields, in the order their values are extracted */
+    const char *const *names;
+    /* The number of names */
+    size_t count;
+    /* A hash table of the index of each name plus one, 0 if empty */
+    unsigned char slots[GDBWIRE_MI_SCHEMA_SLOTS];
+    /* Non-zero once the hash table has been built */
+    int initialized;
+};
+
+/**
+ * Initialize a gdbwire_mi_schema from an array of field names.
+ *
+ * The hash table is built the first time the schema is used. An array
+ * of more than GDBWIRE_MI_SCHEMA_SLOTS / 2 names does not compile.
+ */
+#define GDBWIRE_MI_SCHEMA(names) \
+    { names, sizeof(names) / sizeof((names)[0]) + 0 * sizeof(char[ \
+        sizeof(names) / sizeof((names)[0]) <= GDBWIRE_MI_SCHEMA_SLOTS / 2 ? \
+        1 : -1]), { 0 }, 0 }
+
+/**
+ * Extract the fields of a schema from the results of a tuple.
+ *
+ * @param schema
+ * The fields to extract.
+ *
+ * @param result
+ * The first result of the tuple.
+ *
+ * @param values
+ * An array of schema->count values. Each is set to the cstring of the
+ * last result named by the field at the same index of the schema,
+ * or NULL if the tuple has no such result. All of them are NULL if the
+ * schema has more than GDBWIRE_MI_SCHEMA_SLOTS / 2 fields.
+ *
+ * @return
+ * The number of results that were not cstrings. These are skipped.
+ */
+size_t gdbwire_mi_schema_extract(struct gdbwire_mi_schema *schema,
+        struct gdbwire_mi_result *result, char **values);
+
 /**
  * Free the gdbwire mi command.
  *
@@ -3153,6 +3590,69 @@ void gdbwire_destroy(struct gdbwire *wire);
 enum gdbwire_result gdbwire_push_data(struct gdbwire *wire, const char *data,
         size_t size);
 
+/**
+ * Hand the elements of a list to a callback as they are parsed.
+ *
+ * See gdbwire_mi_parser_stream_list.
+ *
+ * @param wire
+ * The gdbwire context to operate on.
+ *
+ * @param path
+ * The variables leading to the list from the result record, separated
+ * by periods.
+ *
+ * @param callback
+ * Called with each element of the list.
+ *
+ * @param context
+ * Passed to the callback.
+ *
+ * @return
+ * GDBWIRE_OK on success or GDBWIRE_NOMEM if out of memory.
+ */
+enum gdbwire_result gdbwire_stream_list(struct gdbwire *wire,
+        const char *path,
+        void (*callback)(void *context, const char *token,
+            struct gdbwire_mi_result *element),
+        void *context);
+
+/**
+ * Set how much of the async records of a class gdbwire parses.
+ *
+ * See gdbwire_mi_parser_set_async_interest.
+ *
+ * @param wire
+ * The gdbwire context to operate on.
+ *
+ * @param async_class
+ * The async class.
+ *
+ * @param interest
+ * How much of the records to parse.
+ */
+void gdbwire_set_async_interest(struct gdbwire *wire,
+        enum gdbwire_mi_async_class async_class,
+        enum gdbwire_mi_interest interest);
+
+/**
+ * Set how much of the stream records of a kind gdbwire parses.
+ *
+ * See gdbwire_mi_parser_set_stream_interest.
+ *
+ * @param wire
+ * The gdbwire context to operate on.
+ *
+ * @param kind
+ * The kind of stream record.
+ *
+ * @param interest
+ * How much of the records to parse.
+ */
+void gdbwire_set_stream_interest(struct gdbwire *wire,
+        enum gdbwire_mi_stream_record_kind kind,
+        enum gdbwire_mi_interest interest);
+
 /**
  * Handle an interpreter-exec command.
  *
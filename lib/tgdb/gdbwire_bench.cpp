@@ -0,0 +1,785 @@
+/**
+ * Benchmark and check the GDB/MI parser.
+ *
+ * GDB/MI transcripts are pushed through gdbwire_mi_parser_push_data in
+ * chunks of 1 byte, 4 KB and the whole transcript at once, the way tgdb
+ * receives them from gdb in the worst, typical and best case. For each
+ * run the records/s, MB/s, number of allocations and peak heap use are
+ * reported.
+ *
+ * The transcripts are synthetic ones modeled on the largest output gdb
+ * sends, or the machine interface output of files recorded with
+ * tgdb_driver --record, or plain files of GDB/MI output. One synthetic
+ * transcript is made of randomly mutated lines, most of them not valid
+ * GDB/MI.
+ *
+ * With --check, the transcripts are parsed with and without the hand
+ * written parser at every chunk size, and the parse trees are compared.
+ * The lists tgdb streams are streamed in the check as well.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#if HAVE_STDIO_H
+#include <stdio.h>
+#endif /* HAVE_STDIO_H */
+
+#if HAVE_STDARG_H
+#include <stdarg.h>
+#endif /* HAVE_STDARG_H */
+
+#if HAVE_STDLIB_H
+#include <stdlib.h>
+#endif /* HAVE_STDLIB_H */
+
+#if HAVE_STRING_H
+#include <string.h>
+#endif /* HAVE_STRING_H */
+
+#if HAVE_ERRNO_H
+#include <errno.h>
+#endif /* HAVE_ERRNO_H */
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/* Local includes */
+#include "gdbwire.h"
+#include "tgdb.h"
+
+/* Allocation counting {{{ */
+
+/* The number of allocations made, and the heap in use and its peak */
+static unsigned long alloc_count;
+static size_t alloc_live;
+static size_t alloc_peak;
+
+#ifdef __GLIBC__
+
+/**
+ * Replace the allocator with one that counts.
+ *
+ * glibc lets a program define malloc and friends, and provides the
+ * real ones under __libc_ names. Other C libraries do not, so the
+ * allocations are only reported on glibc.
+ */
+#define HAVE_ALLOC_COUNT 1
+
+extern "C" {
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static void alloc_add(void *ptr)
+{
+    if (ptr) {
+        ++alloc_count;
+        alloc_live += malloc_usable_size(ptr);
+        if (alloc_live > alloc_peak)
+            alloc_peak = alloc_live;
+    }
+}
+
+static void alloc_remove(void *ptr)
+{
+    if (ptr)
+        alloc_live -= malloc_usable_size(ptr);
+}
+
+void *malloc(size_t size) noexcept
+{
+    void *ptr = __libc_malloc(size);
+    alloc_add(ptr);
+    return ptr;
+}
+
+void *calloc(size_t nmemb, size_t size) noexcept
+{
+    void *ptr = __libc_calloc(nmemb, size);
+    alloc_add(ptr);
+    return ptr;
+}
+
+void *realloc(void *ptr, size_t size) noexcept
+{
+    size_t old_size = ptr ? malloc_usable_size(ptr) : 0;
+    void *result = __libc_realloc(ptr, size);
+
+    if (result || size == 0) {
+        alloc_live -= old_size;
+        alloc_add(result);
+    }
+
+    return result;
+}
+
+void free(void *ptr) noexcept
+{
+    alloc_remove(ptr);
+    __libc_free(ptr);
+}
+
+}
+
+#else
+#define HAVE_ALLOC_COUNT 0
+#endif
+
+/* }}} */
+
+/* Transcripts {{{ */
+
+/* A GDB/MI transcript to parse */
+struct transcript {
+    std::string name;
+    std::string data;
+};
+
+static void append_printf(std::string &str, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static void append_printf(std::string &str, const char *fmt, ...)
+{
+    char buf[1024];
+    va_list ap;
+    int size;
+
+    va_start(ap, fmt);
+    size = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    if (size > 0)
+        str.append(buf, (size_t)size < sizeof(buf) ? size : sizeof(buf) - 1);
+}
+
+/* A -break-info result with count breakpoints */
+static std::string synthetic_break_info(int count)
+{
+    std::string data;
+    int i;
+
+    append_printf(data, "2^done,BreakpointTable={nr_rows=\"%d\","
+            "nr_cols=\"6\",hdr=[", count);
+    data.append("{width=\"7\",alignment=\"-1\",col_name=\"number\","
+            "colhdr=\"Num\"},{width=\"14\",alignment=\"-1\","
+            "col_name=\"type\",colhdr=\"Type\"},{width=\"4\","
+            "alignment=\"-1\",col_name=\"disp\",colhdr=\"Disp\"},"
+            "{width=\"3\",alignment=\"-1\",col_name=\"enabled\","
+            "colhdr=\"Enb\"},{width=\"18\",alignment=\"-1\","
+            "col_name=\"addr\",colhdr=\"Address\"},{width=\"40\","
+            "alignment=\"2\",col_name=\"what\",colhdr=\"What\"}],body=[");
+
+    for (i = 0; i < count; ++i) {
+        append_printf(data, "%sbkpt={number=\"%d\",type=\"breakpoint\","
+                "disp=\"keep\",enabled=\"y\",addr=\"0x%016x\","
+                "func=\"function_%d\",file=\"src/module%d/file%d.c\","
+                "fullname=\"/home/user/project/src/module%d/file%d.c\","
+                "line=\"%d\",thread-groups=[\"i1\"],times=\"0\","
+                "original-location=\"src/module%d/file%d.c:%d\"}",
+                i ? "," : "", i + 1, 0x400000 + i * 16, i, i % 50, i,
+                i % 50, i, 10 + i % 900, i % 50, i, 10 + i % 900);
+    }
+
+    data.append("]}\n(gdb) \n");
+    return data;
+}
+
+/* A -file-list-exec-source-files result with count files */
+static std::string synthetic_source_files(int count)
+{
+    std::string data = "3^done,files=[";
+    int i;
+
+    for (i = 0; i < count; ++i) {
+        append_printf(data, "%s{file=\"src/module%d/file%d.c\","
+                "fullname=\"/home/user/project/src/module%d/file%d.c\"}",
+                i ? "," : "", i % 50, i, i % 50, i);
+    }
+
+    data.append("]\n(gdb) \n");
+    return data;
+}
+
+/* count stops, each followed by the 64 frame deep stack of the stop */
+static std::string synthetic_stopped(int count)
+{
+    std::string data;
+    int i, level;
+
+    for (i = 0; i < count; ++i) {
+        append_printf(data, "*running,thread-id=\"all\"\n(gdb) \n"
+                "*stopped,reason=\"breakpoint-hit\",disp=\"keep\","
+                "bkptno=\"1\",frame={addr=\"0x%016x\",func=\"walk\","
+                "args=[{name=\"depth\",value=\"%d\"},{name=\"node\","
+                "value=\"0x6020%08x\"},{name=\"key\",value=\"{name = "
+                "0x4006f4 \\\"node %d\\\", next = {left = 0x0, right = "
+                "{value = %d, \\\"\\\\t\\\"}}}\"}],file=\"src/tree.c\","
+                "fullname=\"/home/user/project/src/tree.c\",line=\"%d\","
+                "arch=\"i386:x86-64\"},thread-id=\"1\","
+                "stopped-threads=\"all\",core=\"%d\"\n(gdb) \n",
+                0x400600 + i % 64, i % 64, i * 32, i, i, 40 + i % 20, i % 8);
+
+        append_printf(data, "%d^done,stack=[", 4 + i);
+        for (level = 0; level < 64; ++level) {
+            append_printf(data, "%sframe={level=\"%d\",addr=\"0x%016x\","
+                    "func=\"walk\",file=\"src/tree.c\","
+                    "fullname=\"/home/user/project/src/tree.c\","
+                    "line=\"%d\",arch=\"i386:x86-64\"}",
+                    level ? "," : "", level, 0x400600 + level, 40 + level);
+        }
+        data.append("]\n(gdb) \n");
+    }
+
+    return data;
+}
+
+/* count lines of console, target and log stream records */
+static std::string synthetic_stream(int count)
+{
+    std::string data;
+    int i;
+
+    for (i = 0; i < count; ++i) {
+        if (i % 10 == 9) {
+            append_printf(data, "&\"warning: line %d of the log\\n\"\n", i);
+        } else if (i % 10 == 4) {
+            append_printf(data, "@\"target output %d\\r\\n\"\n", i);
+        } else {
+            append_printf(data, "~\"%d\\t  printf(\\\"%%s: %%d\\\\n\\\", "
+                    "name, value); /* line %d of a long listing */\\n\"\n",
+                    i, i);
+        }
+    }
+
+    data.append("(gdb) \n");
+    return data;
+}
+
+/* A random number below n from a linear congruential generator */
+static size_t mutate_random(unsigned long long &state, size_t n)
+{
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (size_t)((state >> 33) % n);
+}
+
+/**
+ * count lines made by randomly mutating lines GDB sends.
+ *
+ * Bytes are deleted, inserted and repeated, and lines are cut short, so
+ * most of the lines are not valid GDB/MI. This checks that the hand
+ * written parser gives up on everything the grammar rejects, including
+ * partway through a streamed list, and leaves such lines to the grammar.
+ * The same lines are made every time.
+ */
+static std::string synthetic_mutate(int count)
+{
+    static const char *const seeds[] = {
+        "^done\n",
+        "12^done,value=\"42\"\n",
+        "^error,msg=\"No symbol \\\"x\\\" in current context.\"\n",
+        "*running,thread-id=\"all\"\n",
+        "*stopped,reason=\"end-stepping-range\",frame={addr=\"0x400504\","
+            "func=\"main\",args=[],file=\"a.c\",fullname=\"/src/a.c\","
+            "line=\"6\"},thread-id=\"1\",stopped-threads=\"all\"\n",
+        "=library-loaded,id=\"/lib/libc.so.6\",host-name=\"/lib/libc.so.6\","
+            "symbols-loaded=\"0\",thread-group=\"i1\"\n",
+        "=breakpoint-modified,bkpt={number=\"1\",type=\"breakpoint\","
+            "enabled=\"y\",addr=\"<MULTIPLE>\",times=\"1\"},"
+            "{number=\"1.1\",enabled=\"y\",addr=\"0x400501\"}\n",
+        "~\"   0x0000000000400500 <+0>:\\tpush   %rbp\\n\"\n",
+        "&\"warning: \\\"quoted\\\"\\n\"\n",
+        "@\"target output\\r\\n\"\n",
+        "5^done,files=[{file=\"a.c\",fullname=\"/src/a.c\"},{file=\"b.c\"},"
+            "{file=\"c.c\",fullname=\"/src/c.c\"}]\n",
+        "6^done,BreakpointTable={nr_rows=\"2\",nr_cols=\"6\",hdr=[{width=\"7\","
+            "col_name=\"number\"}],body=[bkpt={number=\"1\",enabled=\"y\","
+            "file=\"a.c\",line=\"5\"},bkpt={number=\"2\",enabled=\"n\","
+            "addr=\"0x400510\"}]}\n",
+        "(gdb) \n"
+    };
+    /* The characters the parsers act on. Its null character is used too. */
+    static const char alphabet[] = "\"\\{}[],=^*+~@&()0123456789 \t\r\nab_-";
+    unsigned long long state = 1;
+    std::string data, line;
+    size_t pos;
+    int i;
+
+    for (i = 0; i < count; ++i) {
+        line = seeds[mutate_random(state, sizeof(seeds) / sizeof(seeds[0]))];
+        pos = mutate_random(state, line.size());
+
+        /* Leave about a third of the lines as they are */
+        switch (mutate_random(state, 6)) {
+            case 0:
+                line.erase(pos, 1);
+                break;
+            case 1:
+                line.insert(pos, 1,
+                        alphabet[mutate_random(state, sizeof(alphabet))]);
+                break;
+            case 2:
+                line.insert(pos, line, pos, mutate_random(state, 8));
+                break;
+            case 3:
+                line.resize(pos);
+                line += '\n';
+                break;
+            default:
+                break;
+        }
+
+        data += line;
+    }
+
+    data.append("(gdb) \n");
+    return data;
+}
+
+/* The synthetic transcripts and how big each is at --scale 1 */
+static const struct {
+    const char *name;
+    std::string (*create)(int count);
+    int count;
+} synthetic_transcripts[] = {
+    { "break-info", synthetic_break_info, 20000 },
+    { "source-files", synthetic_source_files, 50000 },
+    { "stopped", synthetic_stopped, 500 },
+    { "stream", synthetic_stream, 200000 },
+    { "mutate", synthetic_mutate, 60000 }
+};
+
+#define SYNTHETIC_COUNT \
+    (sizeof(synthetic_transcripts) / sizeof(synthetic_transcripts[0]))
+
+/**
+ * Read a transcript from a file.
+ *
+ * A tgdb session, see tgdb_record_session, is replaced by the output it
+ * read from the gdb machine interface. Any other file is used as is.
+ *
+ * @return
+ * 0 on success or -1 if the file could not be read.
+ */
+static int read_transcript(const char *path, struct transcript &transcript)
+{
+    const char *header = TGDB_SESSION_HEADER "\n";
+    unsigned long long time;
+    unsigned long size;
+    char stream;
+    char buf[4096];
+    size_t count;
+    FILE *file;
+
+    file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "could not open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    transcript.name = path;
+    while ((count = fread(buf, 1, sizeof(buf), file)) > 0)
+        transcript.data.append(buf, count);
+    fclose(file);
+
+    if (transcript.data.compare(0, strlen(header), header) == 0) {
+        std::string session = transcript.data;
+        size_t pos = strlen(header);
+        int length;
+
+        /* Each record is "TIME STREAM SIZE\nDATA\n" */
+        transcript.data.clear();
+        while (sscanf(session.c_str() + pos, "%llu %c %lu%n",
+                &time, &stream, &size, &length) == 3 &&
+                session[pos + length] == '\n' &&
+                pos + length + size + 1 < session.size()) {
+            if (stream == 'm')
+                transcript.data.append(session, pos + length + 1, size);
+            pos += length + size + 2;
+        }
+    }
+
+    return 0;
+}
+
+/* }}} */
+
+/* Parsing {{{ */
+
+/* The state of one pass of a transcript through the parser */
+struct bench_pass {
+    /* The number of output commands parsed */
+    unsigned long records;
+    /* If not NULL, each output command is described here */
+    std::vector<std::string> *trees;
+    /* The streamed elements of the line being parsed, described */
+    std::vector<std::string> elements;
+};
+
+static void describe_string(std::string &str, const char *value)
+{
+    if (value) {
+        append_printf(str, "%lu:", (unsigned long)strlen(value));
+        str += value;
+    } else {
+        str += "-";
+    }
+    str += ' ';
+}
+
+static void describe_results(std::string &str, struct gdbwire_mi_result *result)
+{
+    for (; result; result = result->next) {
+        describe_string(str, result->variable);
+        if (result->kind == GDBWIRE_MI_CSTRING) {
+            describe_string(str, result->variant.cstring);
+        } else {
+            str += (result->kind == GDBWIRE_MI_TUPLE) ? "{ " : "[ ";
+            describe_results(str, result->variant.result);
+            str += (result->kind == GDBWIRE_MI_TUPLE) ? "} " : "] ";
+        }
+    }
+}
+
+/**
+ * Describe everything in an output command, so that two output
+ * commands can be compared by comparing their descriptions.
+ */
+static std::string describe_output(struct gdbwire_mi_output *output)
+{
+    std::string str;
+
+    append_printf(str, "%d ", output->kind);
+    describe_string(str, output->line);
+
+    if (output->kind == GDBWIRE_MI_OUTPUT_OOB) {
+        struct gdbwire_mi_oob_record *oob = output->variant.oob_record;
+
+        if (oob->kind == GDBWIRE_MI_ASYNC) {
+            struct gdbwire_mi_async_record *record =
+                oob->variant.async_record;
+            describe_string(str, record->token);
+            append_printf(str, "async %d %d ", record->kind,
+                    record->async_class);
+            describe_results(str, record->result);
+        } else {
+            struct gdbwire_mi_stream_record *record =
+                oob->variant.stream_record;
+            append_printf(str, "stream %d ", record->kind);
+            describe_string(str, record->cstring);
+        }
+    } else if (output->kind == GDBWIRE_MI_OUTPUT_RESULT) {
+        struct gdbwire_mi_result_record *record =
+            output->variant.result_record;
+        describe_string(str, record->token);
+        append_printf(str, "result %d ", record->result_class);
+        describe_results(str, record->result);
+    } else if (output->kind == GDBWIRE_MI_OUTPUT_PARSE_ERROR) {
+        describe_string(str, output->variant.error.token);
+        append_printf(str, "error %d %d", output->variant.error.pos.start_column,
+                output->variant.error.pos.end_column);
+    }
+
+    return str;
+}
+
+static void bench_output(void *context, struct gdbwire_mi_output *output)
+{
+    struct bench_pass *pass = (struct bench_pass *)context;
+
+    ++pass->records;
+    if (pass->trees) {
+        /*
+         * The elements streamed ahead of a result record are part of it.
+         * Those of a line that turns out to be a parse error are dropped,
+         * since only the hand written parser hands them over.
+         */
+        if (output->kind == GDBWIRE_MI_OUTPUT_RESULT)
+            pass->trees->insert(pass->trees->end(), pass->elements.begin(),
+                    pass->elements.end());
+        pass->elements.clear();
+        pass->trees->push_back(describe_output(output));
+    }
+
+    gdbwire_mi_output_free(output);
+}
+
+static void bench_element(void *context, const char *token,
+        struct gdbwire_mi_result *element)
+{
+    struct bench_pass *pass = (struct bench_pass *)context;
+    std::string str = "element ";
+
+    describe_string(str, token);
+    describe_results(str, element);
+    pass->elements.push_back(str);
+}
+
+/**
+ * Push a transcript through a new parser.
+ *
+ * @param chunk
+ * The number of bytes to push at a time, 0 for all of them at once.
+ *
+ * @param fast_path
+ * If false, parse with only the grammar.
+ *
+ * @param pass
+ * The pass to count the output commands in.
+ *
+ * @return
+ * 0 on success or -1 if the parser failed.
+ */
+static int bench_parse(const std::string &data, size_t chunk, bool fast_path,
+        struct bench_pass &pass)
+{
+    struct gdbwire_mi_parser_callbacks callbacks = { &pass, bench_output };
+    struct gdbwire_mi_parser *parser = gdbwire_mi_parser_create(callbacks);
+    size_t pos, size;
+    int result = 0;
+
+    if (!parser)
+        return -1;
+
+    gdbwire_mi_parser_use_fast_path(parser, fast_path);
+    gdbwire_mi_parser_keep_lines(parser, pass.trees != NULL);
+
+    /* Check the lists tgdb streams the way tgdb gets them */
+    pass.elements.clear();
+    if (pass.trees &&
+            (gdbwire_mi_parser_stream_list(parser, "files",
+                bench_element, &pass) != GDBWIRE_OK ||
+            gdbwire_mi_parser_stream_list(parser, "BreakpointTable.body",
+                bench_element, &pass) != GDBWIRE_OK)) {
+        gdbwire_mi_parser_destroy(parser);
+        return -1;
+    }
+
+    if (chunk == 0)
+        chunk = data.size();
+
+    for (pos = 0; pos < data.size() && result == 0; pos += size) {
+        size = std::min(chunk, data.size() - pos);
+        if (gdbwire_mi_parser_push_data(parser, data.data() + pos,
+                size) != GDBWIRE_OK)
+            result = -1;
+    }
+
+    gdbwire_mi_parser_destroy(parser);
+    return result;
+}
+
+/* }}} */
+
+/* Benchmark and check {{{ */
+
+static std::string chunk_name(size_t chunk)
+{
+    return chunk ? std::to_string(chunk) : std::string("whole");
+}
+
+/**
+ * Time parsing a transcript and print a row of the results table.
+ *
+ * @return
+ * 0 on success or -1 if the parser failed.
+ */
+static int bench_transcript(const struct transcript &transcript,
+        size_t chunk, bool fast_path)
+{
+    struct bench_pass pass = { 0, NULL };
+    unsigned long allocs = alloc_count;
+    size_t live = alloc_live;
+    double mb = transcript.data.size() / (1024.0 * 1024.0);
+    double seconds;
+    int result;
+
+    alloc_peak = alloc_live;
+
+    auto start = std::chrono::steady_clock::now();
+    result = bench_parse(transcript.data, chunk, fast_path, pass);
+    seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+    printf("%-16s %6s %10lu %8.2f %8.3f %12.0f %8.1f", transcript.name.c_str(),
+            chunk_name(chunk).c_str(), pass.records, mb, seconds,
+            pass.records / seconds, mb / seconds);
+    if (HAVE_ALLOC_COUNT)
+        printf(" %10lu %10lu\n", alloc_count - allocs,
+                (unsigned long)(alloc_peak - live) / 1024);
+    else
+        printf(" %10s %10s\n", "-", "-");
+
+    if (result == -1)
+        fprintf(stderr, "%s: the parser failed\n", transcript.name.c_str());
+
+    return result;
+}
+
+/**
+ * Check that parsing a transcript gives the same output commands with
+ * and without the hand written parser, at every chunk size.
+ *
+ * @return
+ * 0 if they are the same or -1 if not.
+ */
+static int check_transcript(const struct transcript &transcript,
+        const std::vector<size_t> &chunks)
+{
+    std::vector<std::string> expected, trees;
+    struct bench_pass grammar = { 0, &expected }, fast_path = { 0, &trees };
+    size_t i, j;
+
+    for (i = 0; i < chunks.size(); ++i) {
+        expected.clear();
+        trees.clear();
+        if (bench_parse(transcript.data, chunks[i], false, grammar) == -1 ||
+                bench_parse(transcript.data, chunks[i], true,
+                    fast_path) == -1) {
+            fprintf(stderr, "%s: the parser failed\n",
+                    transcript.name.c_str());
+            return -1;
+        }
+
+        for (j = 0; j < expected.size() && j < trees.size(); ++j) {
+            if (expected[j] != trees[j])
+                break;
+        }
+
+        if (j < expected.size() || j < trees.size()) {
+            std::string a = j < expected.size() ? expected[j] : "(none)";
+            std::string b = j < trees.size() ? trees[j] : "(none)";
+            size_t pos = std::mismatch(a.begin(), a.begin() +
+                    std::min(a.size(), b.size()), b.begin()).first - a.begin();
+
+            /* Show where the descriptions start to differ */
+            pos = pos > 40 ? pos - 40 : 0;
+            fprintf(stderr, "%s: the fast path differs from the grammar "
+                    "at output %lu with chunk %s\n"
+                    "  grammar:   %.120s\n  fast path: %.120s\n",
+                    transcript.name.c_str(), (unsigned long)j,
+                    chunk_name(chunks[i]).c_str(), a.c_str() + pos,
+                    b.c_str() + pos);
+            return -1;
+        }
+    }
+
+    printf("%-16s %lu outputs match\n", transcript.name.c_str(),
+            (unsigned long)expected.size());
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "Usage: gdbwire_bench [OPTION]... [FILE]...\n"
+            "Benchmark the GDB/MI parser with the transcripts in FILE,\n"
+            "which are tgdb_driver --record sessions or GDB/MI output.\n"
+            "Without FILE, the synthetic transcripts are used.\n"
+            "\n"
+            "  --chunk N        push N bytes at a time, 0 for the whole\n"
+            "                   transcript, may be repeated\n"
+            "                   (default 1, 4096 and 0)\n"
+            "  --synthetic NAME use the synthetic transcript NAME, may be\n"
+            "                   repeated, one of:");
+    for (size_t i = 0; i < SYNTHETIC_COUNT; ++i)
+        fprintf(stderr, " %s", synthetic_transcripts[i].name);
+    fprintf(stderr, "\n"
+            "  --scale N        make the synthetic transcripts N times bigger\n"
+            "  --grammar        benchmark without the hand written parser\n"
+            "  --check          check the hand written parser gives the same\n"
+            "                   output commands as the grammar\n");
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<struct transcript> transcripts;
+    std::vector<const char *> synthetic;
+    std::vector<size_t> chunks;
+    bool check = false, fast_path = true;
+    int scale = 1, result = 0, i;
+    size_t j;
+
+    for (i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) {
+            chunks.push_back(strtoul(argv[++i], NULL, 10));
+        } else if (strcmp(argv[i], "--synthetic") == 0 && i + 1 < argc) {
+            synthetic.push_back(argv[++i]);
+        } else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--grammar") == 0) {
+            fast_path = false;
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else if (argv[i][0] == '-') {
+            usage();
+            return 1;
+        } else {
+            struct transcript transcript;
+            if (read_transcript(argv[i], transcript) == -1)
+                return 1;
+            transcripts.push_back(transcript);
+        }
+    }
+
+    if (chunks.empty()) {
+        chunks.push_back(1);
+        chunks.push_back(4096);
+        chunks.push_back(0);
+    }
+
+    if (transcripts.empty() && synthetic.empty()) {
+        for (j = 0; j < SYNTHETIC_COUNT; ++j)
+            synthetic.push_back(synthetic_transcripts[j].name);
+    }
+
+    for (const char *name : synthetic) {
+        for (j = 0; j < SYNTHETIC_COUNT; ++j) {
+            if (strcmp(name, synthetic_transcripts[j].name) == 0)
+                break;
+        }
+
+        if (j == SYNTHETIC_COUNT) {
+            fprintf(stderr, "unknown synthetic transcript %s\n", name);
+            usage();
+            return 1;
+        }
+
+        struct transcript transcript;
+        transcript.name = name;
+        transcript.data = synthetic_transcripts[j].create(
+                synthetic_transcripts[j].count * scale);
+        transcripts.push_back(transcript);
+    }
+
+    if (check) {
+        for (const struct transcript &transcript : transcripts) {
+            if (check_transcript(transcript, chunks) == -1)
+                result = 1;
+        }
+        return result;
+    }
+
+    printf("%-16s %6s %10s %8s %8s %12s %8s %10s %10s\n", "transcript",
+            "chunk", "records", "MB", "seconds", "records/s", "MB/s",
+            "allocs", "peak KB");
+    for (const struct transcript &transcript : transcripts) {
+        for (size_t chunk : chunks) {
+            if (bench_transcript(transcript, chunk, fast_path) == -1)
+                result = 1;
+        }
+    }
+
+    return result;
+}
+
+/* }}} */
@@ -19,6 +19,14 @@
 #include <string.h>
 #endif /* HAVE_STRING_H */
 
+#if HAVE_STDARG_H
+#include <stdarg.h>
+#endif /* HAVE_STDARG_H */
+
+#if HAVE_CTYPE_H
+#include <ctype.h>
+#endif
+
 #if HAVE_SYS_WAIT_H
 #include <sys/wait.h>
 #endif
@@ -26,8 +34,12 @@
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 
+#include <algorithm>
+#include <chrono>
 #include <list>
-#include <sstream>
+#include <map>
+#include <unordered_set>
+#include <vector>
 
 #include "tgdb.h"
 #include "fork_util.h"
@@ -45,6 +57,162 @@
 
 typedef struct tgdb_request *tgdb_request_ptr;
 typedef std::list<tgdb_request_ptr> tgdb_request_ptr_list;
+typedef std::map<unsigned long, tgdb_request_ptr> tgdb_request_ptr_map;
+typedef std::map<int, struct tgdb_breakpoint *> tgdb_breakpoint_map;
+
+// Hash and compare null terminated strings by their characters, so a
+// string can be looked up without copying it into a std::string
+struct tgdb_string_hash {
+    size_t operator()(const char *str) const {
+        // FNV-1a
+        uint64_t hash = 14695981039346656037ULL;
+
+        for (; *str; ++str) {
+            hash = (hash ^ (unsigned char)*str) * 1099511628211ULL;
+        }
+
+        return (size_t)hash;
+    }
+};
+
+struct tgdb_string_equal {
+    bool operator()(const char *lhs, const char *rhs) const {
+        return strcmp(lhs, rhs) == 0;
+    }
+};
+
+// The strings tgdb interned, see tgdb_intern. The set owns them.
+typedef std::unordered_set<const char *, tgdb_string_hash,
+        tgdb_string_equal> tgdb_string_set;
+
+// A disassembled instruction, as reported by -data-disassemble
+struct tgdb_disasm_insn {
+    // The size of the instruction in bytes, taken from its raw opcodes
+    uint64_t size;
+
+    // The number of hex digits gdb printed the address with. GDB pads
+    // addresses to the width of the architecture's addresses.
+    int address_digits;
+
+    // The function the instruction is in and its offset into it,
+    // or empty if unknown
+    std::string func;
+    std::string offset;
+
+    // The raw opcodes and the instruction text
+    std::string opcodes;
+    std::string inst;
+
+    // The source file and line the instruction was generated from,
+    // or an empty file and 0 if unknown
+    std::string file;
+    std::string fullname;
+    int line;
+
+    // True if every instruction of the function is in the cache
+    bool whole_function;
+};
+
+// Disassembled instructions keyed by address.
+//
+// Instructions fetched by separate requests end up next to each other
+// in the map, so adjacent address ranges are merged automatically.
+typedef std::map<uint64_t, struct tgdb_disasm_insn> tgdb_disasm_cache;
+
+// The lines of the source files shown in source centric disassembly,
+// keyed by full path. Each file is read once and kept as long as the
+// instructions in the disassembly cache.
+typedef std::map<std::string, std::vector<std::string> > tgdb_disasm_sources;
+
+/**
+ * -data-disassemble works on address ranges rather than instruction
+ * counts. When asked for a number of instructions, request this many bytes
+ * per instruction. That covers the typical instruction lengths of variable
+ * length instruction sets.
+ */
+#define TGDB_DISASSEMBLE_BYTES_PER_LINE 8
+
+/**
+ * The maximum number of mi commands written to gdb that may be waiting
+ * for their result record at the same time.
+ */
+#define TGDB_MAX_PENDING_REQUESTS 8
+
+/**
+ * The smallest and largest size of the buffer gdb output is read into.
+ * A read that fills the buffer doubles its size.
+ */
+#define TGDB_READ_BUFFER_MIN 4096
+#define TGDB_READ_BUFFER_MAX (1024 * 1024)
+
+/**
+ * How much of the start of a console line is kept while waiting for the
+ * rest of the line. Enough for the longest string tgdb searches for.
+ */
+#define TGDB_CONSOLE_LINE_PREFIX 64
+
+/** The number of request types in enum tgdb_request_type */
+#define TGDB_REQUEST_TYPE_COUNT (TGDB_REQUEST_DISASSEMBLE_FUNC + 1)
+
+/**
+ * The most destroyed requests and sent responses kept around to be
+ * reused. Only a handful are ever alive at once.
+ */
+#define TGDB_POOL_MAX 16
+
+// The stages a request goes through, measured between its timestamps
+enum tgdb_latency_phase {
+    // From being made until it is written to gdb
+    TGDB_LATENCY_QUEUED,
+
+    // From being written to gdb until gdb starts answering it
+    TGDB_LATENCY_GDB,
+
+    // From gdb starting to answer until its result record is parsed
+    TGDB_LATENCY_READ,
+
+    // From the result record until tgdb finished processing it
+    TGDB_LATENCY_DELIVER,
+
+    // From being made until tgdb finished processing it
+    TGDB_LATENCY_TOTAL,
+
+    TGDB_LATENCY_PHASE_COUNT
+};
+
+/**
+ * Each power of two microseconds is split into this many histogram
+ * buckets, so percentiles are reported within 1/8th of their value.
+ */
+#define TGDB_LATENCY_SUB_BUCKETS 8
+#define TGDB_LATENCY_BUCKETS (64 * TGDB_LATENCY_SUB_BUCKETS)
+
+// A histogram of latencies, in microseconds
+struct tgdb_latency_histogram {
+    unsigned long count;
+    uint64_t max;
+    unsigned long buckets[TGDB_LATENCY_BUCKETS];
+};
+
+// The latencies of every request tgdb has completed, by request type
+struct tgdb_latency_stats {
+    struct tgdb_latency_histogram
+        histograms[TGDB_REQUEST_TYPE_COUNT][TGDB_LATENCY_PHASE_COUNT];
+};
+
+// Data waiting to be written to one of gdb's file descriptors.
+//
+// Writes to gdb never block. Whatever gdb does not accept right away is
+// kept here, in order, until the descriptor is writable again.
+struct tgdb_write_queue {
+    std::string data;
+
+    // The number of bytes at the front of data that were already written
+    size_t offset;
+
+    // The most bytes that have been left waiting at once
+    size_t max_size;
+};
 
 /**
  * The TGDB context data structure.
@@ -74,35 +242,94 @@ struct tgdb {
     tgdb_request_ptr_list *command_requests;
 
     /**
-     * If set to 1, libtgdb thinks the lower level subsystem is capable of
-     * receiving another command. It needs this so that it doesn't send 2
-     * commands to the lower level before it can say it can't receive a command.
-     * At some point, maybe this can be removed?
-     * When its set to 0, libtgdb thinks it can not send the lower level another
-     * command.
+     * The mi commands written to gdb that have not received their result
+     * record yet, keyed by the token the command was sent with.
      *
-     * Basically whether gdb is at prompt or not. */
-    int is_gdb_ready_for_next_command;
+     * GDB executes the commands on the mi channel in the order they were
+     * written, so the first entry is the command gdb is currently running.
+     */
+    tgdb_request_ptr_map *pending_requests;
+
+    /** The token to tag the next mi command with */
+    unsigned long next_token;
+
+    /**
+     * Set to 1 once gdb has displayed its first prompt on the new-ui mi
+     * channel. Until then, commands are only queued.
+     */
+    int is_mi_channel_ready;
 
     /** If ^c was hit by user */
     sig_atomic_t control_c;
 
     tgdb_callbacks callbacks;
 
-    // commands structure
-    // The current command request type that is executing. NULL to start.
-    enum tgdb_request_type current_request_type;
+    // The time the mi channel was last read, in microseconds
+    uint64_t mi_read_time;
+
+    // How long the requests tgdb completed took
+    struct tgdb_latency_stats *latency_stats;
+
+    // The file the session is being recorded to, or NULL if it is not
+    FILE *session_file;
 
-    // The disassemble command output.
-    char **disasm;
-    uint64_t address_start, address_end;
+    // The time the session recording started, in microseconds
+    uint64_t session_start_time;
+
+    // Every instruction gdb has disassembled for the current process.
+    //
+    // Disassembly requests are answered from here when possible, so
+    // stepping through code that was already seen never asks gdb again.
+    tgdb_disasm_cache *disasm_cache;
+
+    // The source lines of the instructions in disasm_cache, read the
+    // first time they are shown
+    tgdb_disasm_sources *disasm_sources;
 
     // The gdbwire context to talk to GDB with.
     struct gdbwire *wire;
 
+    // The breakpoints last reported to the front end, keyed by breakpoint
+    // number. Each value is the list of locations reported for that
+    // breakpoint, or NULL if it has none that can be displayed.
+    //
+    // Used to turn breakpoint async records into changes.
+    tgdb_breakpoint_map *breakpoints;
+
+    // The source files of the program being debugged, as last reported
+    // by -file-list-exec-source-files. A stretchy array of interned
+    // strings.
+    //
+    // Fetched in the background whenever gdb loads symbols, so the file
+    // dialog can be opened without waiting for gdb.
+    const char **source_files;
+
+    // True if source_files matches what gdb would report right now
+    bool source_files_valid;
+
+    // True if the symbols changed since the last source file request
+    // was written to gdb, making its answer out of date
+    bool source_files_stale;
+
+    // True if the front end asked for the source files and has not
+    // been sent them yet
+    bool source_files_wanted;
+
     // True if the disassemble command supports /s, otherwise false.
     int disassemble_supports_s_mode;
 
+    // True if -data-disassemble supports -a, otherwise false.
+    int disassemble_supports_a_option;
+
+    // True while a CLI disassemble command is running, see
+    // tgdb_disassemble_cli_line. Nothing else is sent to gdb meanwhile.
+    bool cli_disassembling;
+
+    // The lines the running CLI disassemble command printed so far and
+    // the range of addresses in them. The lines are a stretchy array.
+    char **cli_disasm;
+    uint64_t cli_disasm_start, cli_disasm_end;
+
     // True if GDB supports the 'new-ui' command, otherwise false.
     // If gdb prints out,
     //   Undefined command: "new-ui".  Try "help".
@@ -110,15 +337,74 @@ struct tgdb {
     // Otherwise it is assumed that it does support the command.
     bool gdb_supports_new_ui_command;
 
-    // Temporary buffer used to store the line by line console output
-    // in order to search for the unsupported new ui string above.
-    std::string *undefined_new_ui_command;
+    // The start of the last line of console output, if that line has
+    // not been completed yet. Used to search for the unsupported new ui
+    // string above, and for gdb reading in symbols.
+    std::string *console_partial_line;
+
+    // The buffer gdb output is read into. It grows when gdb writes more
+    // than fits in it between two calls to tgdb_process.
+    char *read_buffer;
+    size_t read_buffer_size;
+
+    // The data waiting to be written to the console and mi channels
+    struct tgdb_write_queue *console_writes;
+    struct tgdb_write_queue *mi_writes;
+
+    // The file paths and function names sent to the front end. Each is
+    // kept once for the life of tgdb, so the same path is always the
+    // same pointer and a stop does not copy its location.
+    tgdb_string_set *interned_strings;
+
+    // Destroyed requests and sent responses, stretchy arrays kept to
+    // be reused instead of freed
+    struct tgdb_request **request_pool;
+    struct tgdb_response_slot **response_pool;
+};
+
+// A response and the file position a TGDB_UPDATE_FILE_POSITION
+// response points to, allocated together
+struct tgdb_response_slot {
+    struct tgdb_response response;
+    struct tgdb_file_position file_position;
+};
+
+// The scheduling class of a request.
+//
+// Queued requests run in order of their class and in the order they
+// were made within a class.
+enum tgdb_request_priority {
+    // Requests that refresh debugger state after gdb changed it,
+    // like the current location or the breakpoint list
+    TGDB_PRIORITY_STATE,
+
+    // Requests made on behalf of the user
+    TGDB_PRIORITY_USER,
+
+    // Requests that prefetch data the user may ask for later.
+    // These are only sent to gdb when no other command is in flight.
+    TGDB_PRIORITY_BACKGROUND
 };
 
 // This is the type of request
 struct tgdb_request {
     enum tgdb_request_type header;
 
+    // The scheduling class the request was queued with
+    enum tgdb_request_priority priority;
+
+    // When the request went through each stage, in microseconds as
+    // returned by tgdb_time_usec(), or 0 if it has not yet.
+    //
+    // The first byte is the first read from the mi channel that
+    // happened while gdb was working on this request, or that contained
+    // its result.
+    uint64_t enqueue_time;
+    uint64_t send_time;
+    uint64_t first_byte_time;
+    uint64_t result_time;
+    uint64_t done_time;
+
     union {
         struct {
             // The null terminated console command to pass to GDB
@@ -146,165 +432,1579 @@ struct tgdb_request {
         } modify_breakpoint;
 
         struct {
+            // The address to start disassembling at
+            uint64_t addr;
             int lines;
         } disassemble;
 
         struct {
+            // An address in the function to disassemble
+            uint64_t addr;
             int source;
             int raw;
         } disassemble_func;
+
+        // The answer of -file-list-exec-source-files, as gdbwire streams
+        // its files ahead of the result record
+        struct {
+            // The source files so far, a stretchy array of interned
+            // strings
+            const char **source_files;
+            // True if a file could not be converted
+            bool error;
+        } info_sources;
+
+        // The answer of -break-info, as gdbwire streams the rows of its
+        // breakpoint table ahead of the result record
+        struct {
+            // The locations of every breakpoint so far, a stretchy array
+            struct tgdb_breakpoint *breakpoints;
+            // The same locations keyed by breakpoint number, or NULL
+            tgdb_breakpoint_map *table;
+            // The number of the last breakpoint, which the rows of
+            // its multiple locations follow
+            int number;
+            bool multi;
+            bool number_set;
+            // True if a row could not be converted
+            bool error;
+        } breakpoints;
     } choice;
 };
 
 /* }}} */
 
 /* Temporary prototypes {{{ */
-struct tgdb_response *tgdb_create_response(enum tgdb_response_type header);
+struct tgdb_response *tgdb_create_response(struct tgdb *tgdb,
+        enum tgdb_response_type header);
 void tgdb_send_response(struct tgdb *tgdb, struct tgdb_response *response);
 static void tgdb_run_request(struct tgdb *tgdb, struct tgdb_request *request);
-static void tgdb_unqueue_and_deliver_command(struct tgdb *tgdb);
+static tgdb_request_ptr tgdb_request_create(struct tgdb *tgdb,
+        enum tgdb_request_type header);
+static void tgdb_request_destroy(struct tgdb *tgdb,
+        tgdb_request_ptr request_ptr);
+static void tgdb_unqueue_and_deliver_commands(struct tgdb *tgdb);
 void tgdb_run_or_queue_request(struct tgdb *tgdb,
-        struct tgdb_request *request, bool priority);
+        struct tgdb_request *request, enum tgdb_request_priority priority);
+static void tgdb_supersede_location_requests(struct tgdb *tgdb);
+static void tgdb_source_files_changed(struct tgdb *tgdb);
 
 /* }}} */
 
-// Command Functions {{{
-static void
-tgdb_commands_send_breakpoints(struct tgdb *tgdb,
-    struct tgdb_breakpoint *breakpoints)
+// Latency statistics {{{
+
+/**
+ * Get the current time from a clock that never goes backwards.
+ *
+ * @return
+ * The time in microseconds since an unspecified point in the past.
+ */
+static uint64_t tgdb_time_usec(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Get the histogram bucket a latency falls into.
+ *
+ * Latencies below TGDB_LATENCY_SUB_BUCKETS microseconds get a bucket
+ * each. Above that, every power of two is split into
+ * TGDB_LATENCY_SUB_BUCKETS buckets of equal width.
+ */
+static int tgdb_latency_bucket(uint64_t usec)
+{
+    int exponent = 0;
+
+    if (usec < TGDB_LATENCY_SUB_BUCKETS) {
+        return (int)usec;
+    }
+
+    while ((usec >> exponent) >= 2 * TGDB_LATENCY_SUB_BUCKETS) {
+        ++exponent;
+    }
+
+    return (exponent + 1) * TGDB_LATENCY_SUB_BUCKETS +
+        (int)(usec >> exponent) - TGDB_LATENCY_SUB_BUCKETS;
+}
+
+/**
+ * Get the latency in the middle of a histogram bucket.
+ */
+static uint64_t tgdb_latency_bucket_value(int bucket)
+{
+    int exponent = bucket / TGDB_LATENCY_SUB_BUCKETS - 1;
+    uint64_t low;
+
+    if (exponent < 0) {
+        return bucket;
+    }
+
+    low = (uint64_t)(bucket % TGDB_LATENCY_SUB_BUCKETS +
+        TGDB_LATENCY_SUB_BUCKETS) << exponent;
+
+    return low + (((uint64_t)1 << exponent) / 2);
+}
+
+/**
+ * Get the latency that a fraction of the recorded latencies do not
+ * exceed, to within the width of a histogram bucket.
+ *
+ * @param histogram
+ * The histogram to look in. It must not be empty.
+ *
+ * @param fraction
+ * The fraction of latencies, 0.5 for the median.
+ */
+static uint64_t tgdb_latency_percentile(
+        struct tgdb_latency_histogram *histogram, double fraction)
+{
+    unsigned long rank = (unsigned long)(fraction * histogram->count + 0.5);
+    unsigned long seen = 0;
+    int i;
+
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    for (i = 0; i < TGDB_LATENCY_BUCKETS; ++i) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            // The maximum is exact, prefer it within its own bucket
+            if (i == tgdb_latency_bucket(histogram->max)) {
+                return histogram->max;
+            }
+            return tgdb_latency_bucket_value(i);
+        }
+    }
+
+    return histogram->max;
+}
+
+static void tgdb_latency_add(struct tgdb_latency_histogram *histogram,
+        uint64_t start, uint64_t end)
+{
+    uint64_t usec = end > start ? end - start : 0;
+
+    histogram->count++;
+    histogram->buckets[tgdb_latency_bucket(usec)]++;
+    if (usec > histogram->max) {
+        histogram->max = usec;
+    }
+}
+
+/**
+ * Add the latencies of a completed request to the statistics.
+ */
+static void tgdb_latency_record(struct tgdb *tgdb, tgdb_request_ptr request)
+{
+    struct tgdb_latency_histogram *histograms =
+        tgdb->latency_stats->histograms[request->header];
+
+    tgdb_latency_add(&histograms[TGDB_LATENCY_QUEUED],
+            request->enqueue_time, request->send_time);
+    tgdb_latency_add(&histograms[TGDB_LATENCY_GDB],
+            request->send_time, request->first_byte_time);
+    tgdb_latency_add(&histograms[TGDB_LATENCY_READ],
+            request->first_byte_time, request->result_time);
+    tgdb_latency_add(&histograms[TGDB_LATENCY_DELIVER],
+            request->result_time, request->done_time);
+    tgdb_latency_add(&histograms[TGDB_LATENCY_TOTAL],
+            request->enqueue_time, request->done_time);
+}
+
+static const char *tgdb_request_type_name(int type)
+{
+    switch (type) {
+        case TGDB_REQUEST_INFO_SOURCES:
+            return "info_sources";
+        case TGDB_REQUEST_INFO_SOURCE_FILE:
+            return "info_source_file";
+        case TGDB_REQUEST_BREAKPOINTS:
+            return "breakpoints";
+        case TGDB_REQUEST_TTY:
+            return "tty";
+        case TGDB_REQUEST_INFO_FRAME:
+            return "info_frame";
+        case TGDB_REQUEST_DATA_DISASSEMBLE_MODE_QUERY:
+            return "disassemble_mode_query";
+        case TGDB_REQUEST_DATA_DISASSEMBLE_FUNC_QUERY:
+            return "disassemble_func_query";
+        case TGDB_REQUEST_DEBUGGER_COMMAND:
+            return "debugger_command";
+        case TGDB_REQUEST_MODIFY_BREAKPOINT:
+            return "modify_breakpoint";
+        case TGDB_REQUEST_DISASSEMBLE_PC:
+            return "disassemble_pc";
+        case TGDB_REQUEST_DISASSEMBLE_FUNC:
+            return "disassemble_func";
+    }
+
+    return "unknown";
+}
+
+static const char *tgdb_latency_phase_name(int phase)
+{
+    switch (phase) {
+        case TGDB_LATENCY_QUEUED:
+            return "queued";
+        case TGDB_LATENCY_GDB:
+            return "gdb";
+        case TGDB_LATENCY_READ:
+            return "read";
+        case TGDB_LATENCY_DELIVER:
+            return "deliver";
+        case TGDB_LATENCY_TOTAL:
+            return "total";
+    }
+
+    return "unknown";
+}
+
+std::string tgdb_get_request_stats(struct tgdb *tgdb)
+{
+    std::string stats;
+    char *line;
+    int type, phase;
+
+    line = sys_aprintf("%-24s %-8s %8s %10s %10s %10s\n",
+            "request", "phase", "count", "p50 ms", "p99 ms", "max ms");
+    stats = line;
+    free(line);
+
+    for (type = 0; type < TGDB_REQUEST_TYPE_COUNT; ++type) {
+        for (phase = 0; phase < TGDB_LATENCY_PHASE_COUNT; ++phase) {
+            struct tgdb_latency_histogram *histogram =
+                &tgdb->latency_stats->histograms[type][phase];
+
+            if (histogram->count == 0) {
+                continue;
+            }
+
+            line = sys_aprintf("%-24s %-8s %8lu %10.3f %10.3f %10.3f\n",
+                    phase == 0 ? tgdb_request_type_name(type) : "",
+                    tgdb_latency_phase_name(phase), histogram->count,
+                    tgdb_latency_percentile(histogram, 0.50) / 1000.0,
+                    tgdb_latency_percentile(histogram, 0.99) / 1000.0,
+                    histogram->max / 1000.0);
+            stats += line;
+            free(line);
+        }
+    }
+
+    line = sys_aprintf("\n%-24s %8s %10s\n"
+            "%-24s %8lu %10lu\n%-24s %8lu %10lu\n",
+            "gdb write queue", "bytes", "max bytes",
+            "console", (unsigned long)tgdb_pending_write_size(
+                    tgdb, tgdb->debugger_stdin),
+            (unsigned long)tgdb->console_writes->max_size,
+            "mi", (unsigned long)tgdb_pending_write_size(
+                    tgdb, tgdb->gdb_mi_ui_fd),
+            (unsigned long)tgdb->mi_writes->max_size);
+    stats += line;
+    free(line);
+
+    return stats;
+}
+
+// }}}
+
+// Session recording {{{
+
+/**
+ * Write a record to the session file, if the session is being recorded.
+ *
+ * @param tgdb
+ * The tgdb instance
+ *
+ * @param stream
+ * The stream the data belongs to, see tgdb_record_session()
+ *
+ * @param data
+ * The data to record
+ *
+ * @param size
+ * The number of bytes in data
+ */
+static void tgdb_session_record(struct tgdb *tgdb, char stream,
+        const char *data, size_t size)
+{
+    if (!tgdb->session_file) {
+        return;
+    }
+
+    fprintf(tgdb->session_file, "%" PRIu64 " %c %lu\n",
+            tgdb_time_usec() - tgdb->session_start_time, stream,
+            (unsigned long)size);
+    fwrite(data, 1, size, tgdb->session_file);
+    fputc('\n', tgdb->session_file);
+}
+
+/**
+ * Record a call the front end made into tgdb.
+ *
+ * @param fmt
+ * The name of the call followed by its arguments, separated by spaces
+ */
+static void tgdb_session_record_request(struct tgdb *tgdb,
+        const char *fmt, ...) ATTRIBUTE_PRINTF(2, 3);
+
+static void tgdb_session_record_request(struct tgdb *tgdb,
+        const char *fmt, ...)
+{
+    va_list ap;
+    int size;
+    std::string request;
+
+    if (!tgdb->session_file) {
+        return;
+    }
+
+    va_start(ap, fmt);
+    size = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+
+    request.resize(size + 1);
+
+    va_start(ap, fmt);
+    vsnprintf(&request[0], size + 1, fmt, ap);
+    va_end(ap);
+
+    tgdb_session_record(tgdb, 'R', request.data(), size);
+}
+
+int tgdb_record_session(struct tgdb *tgdb, const char *path)
+{
+    tgdb->session_file = fopen(path, "wb");
+    if (!tgdb->session_file) {
+        clog_error(CLOG_CGDB, "could not open %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    fprintf(tgdb->session_file, "%s\n", TGDB_SESSION_HEADER);
+    tgdb->session_start_time = tgdb_time_usec();
+
+    return 0;
+}
+
+// }}}
+
+// Writing to gdb {{{
+
+/**
+ * Get the write queue for one of gdb's file descriptors.
+ *
+ * @param tgdb
+ * The tgdb instance
+ *
+ * @param fd
+ * The console or mi file descriptor
+ *
+ * @return
+ * The write queue for fd, or NULL if fd is not one of gdb's descriptors
+ */
+static struct tgdb_write_queue *tgdb_write_queue_for(struct tgdb *tgdb,
+        int fd)
+{
+    if (fd == -1) {
+        return NULL;
+    } else if (fd == tgdb->gdb_mi_ui_fd) {
+        return tgdb->mi_writes;
+    } else if (fd == tgdb->debugger_stdin) {
+        return tgdb->console_writes;
+    }
+
+    return NULL;
+}
+
+/**
+ * Write as much of a write queue to its file descriptor as gdb accepts
+ * without blocking.
+ *
+ * @param queue
+ * The queue to write
+ *
+ * @param fd
+ * The file descriptor the queue belongs to
+ *
+ * @return
+ * 0 on success, or -1 on error
+ */
+static int tgdb_write_queue_flush(struct tgdb_write_queue *queue, int fd)
+{
+    while (queue->offset < queue->data.size()) {
+        ssize_t size = write(fd, queue->data.data() + queue->offset,
+                queue->data.size() - queue->offset);
+
+        if (size == -1) {
+            if (errno == EINTR) {
+                continue;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+
+            clog_error(CLOG_CGDB, "write to gdb failed: %s",
+                    strerror(errno));
+            return -1;
+        }
+
+        queue->offset += size;
+    }
+
+    // Only move the unwritten data to the front once most of the
+    // buffer has been written, so slow writes stay linear
+    if (queue->offset == queue->data.size()) {
+        queue->data.clear();
+        queue->offset = 0;
+    } else if (queue->offset > queue->data.size() / 2) {
+        queue->data.erase(0, queue->offset);
+        queue->offset = 0;
+    }
+
+    return 0;
+}
+
+/**
+ * Write data to gdb without blocking.
+ *
+ * The data is written immediately if nothing is waiting ahead of it and
+ * gdb accepts it. Otherwise the rest is queued and written as gdb reads
+ * its input, see tgdb_process_writable().
+ *
+ * @param tgdb
+ * The tgdb instance
+ *
+ * @param fd
+ * The console or mi file descriptor
+ *
+ * @param data
+ * The data to write
+ *
+ * @param size
+ * The number of bytes in data
+ *
+ * @return
+ * 0 on success, or -1 on error
+ */
+static int tgdb_write(struct tgdb *tgdb, int fd, const char *data,
+        size_t size)
+{
+    struct tgdb_write_queue *queue = tgdb_write_queue_for(tgdb, fd);
+    int result;
+
+    if (!queue) {
+        return -1;
+    }
+
+    queue->data.append(data, size);
+    result = tgdb_write_queue_flush(queue, fd);
+    queue->max_size = std::max(queue->max_size,
+            queue->data.size() - queue->offset);
+
+    return result;
+}
+
+size_t tgdb_pending_write_size(struct tgdb *tgdb, int fd)
+{
+    struct tgdb_write_queue *queue = tgdb_write_queue_for(tgdb, fd);
+
+    return queue ? queue->data.size() - queue->offset : 0;
+}
+
+int tgdb_process_writable(struct tgdb *tgdb, int fd)
+{
+    struct tgdb_write_queue *queue = tgdb_write_queue_for(tgdb, fd);
+
+    return queue ? tgdb_write_queue_flush(queue, fd) : 0;
+}
+
+// }}}
+
+// Command Functions {{{
+
+/**
+ * Get the interned copy of a string.
+ *
+ * The paths gdb reports repeat on every stop and in every breakpoint,
+ * so each is copied once and shared by everything sent to the front end.
+ * Interned strings are never freed before tgdb is shut down, and two
+ * of them are equal exactly when their pointers are.
+ *
+ * @return
+ * The interned string, or NULL if str is NULL.
+ */
+static const char *tgdb_intern(struct tgdb *tgdb, const char *str)
+{
+    if (!str) {
+        return NULL;
+    }
+
+    tgdb_string_set::iterator iter = tgdb->interned_strings->find(str);
+    if (iter != tgdb->interned_strings->end()) {
+        return *iter;
+    }
+
+    // Only a string seen for the first time is copied
+    str = cgdb_strdup(str);
+    tgdb->interned_strings->insert(str);
+    return str;
+}
+
+static void
+tgdb_commands_send_breakpoints(struct tgdb *tgdb,
+    struct tgdb_breakpoint *breakpoints)
+{
+    struct tgdb_response *response = (struct tgdb_response *)
+        tgdb_create_response(tgdb, TGDB_UPDATE_BREAKPOINTS);
+
+    response->choice.update_breakpoints.breakpoints = breakpoints;
+
+    tgdb_send_response(tgdb, response);
+}
+
+static void tgdb_commands_process_breakpoint(struct tgdb *tgdb,
+        struct tgdb_breakpoint *&breakpoints,
+        struct gdbwire_mi_breakpoint *breakpoint)
+{
+    bool file_location_avialable =
+        (breakpoint->fullname || breakpoint->file) && breakpoint->line != 0;
+    bool assembly_location_available = breakpoint->address && 
+        !breakpoint->pending && !breakpoint->multi;
+
+    if (file_location_avialable || assembly_location_available) {
+        struct tgdb_breakpoint tb;
+
+        if (file_location_avialable) {
+            tb.path = tgdb_intern(tgdb, (breakpoint->fullname)?
+                breakpoint->fullname : breakpoint->file);
+            tb.line = breakpoint->line;
+        } else {
+            tb.path = 0;
+            tb.line = 0;
+        }
+
+        if (assembly_location_available) {
+            uint64_t address = 0;
+            cgdb_hexstr_to_u64(breakpoint->address, &address);
+            tb.addr = address;
+        } else {
+            tb.addr = 0;
+        }
+
+        tb.enabled = breakpoint->enabled;
+        sbpush(breakpoints, tb);
+    }
+}
+
+/**
+ * Get the locations of a breakpoint that the front end can display.
+ *
+ * @param breakpoint
+ * The gdbwire breakpoint, including any multiple locations
+ *
+ * @return
+ * A stretchy array of locations, or NULL if there are none.
+ */
+static struct tgdb_breakpoint *tgdb_breakpoint_locations(struct tgdb *tgdb,
+        struct gdbwire_mi_breakpoint *breakpoint)
+{
+    struct tgdb_breakpoint *locations = NULL;
+
+    tgdb_commands_process_breakpoint(tgdb, locations, breakpoint);
+
+    if (breakpoint->multi) {
+        struct gdbwire_mi_breakpoint *multi_bkpt =
+            breakpoint->multi_breakpoints;
+        while (multi_bkpt) {
+            tgdb_commands_process_breakpoint(tgdb, locations, multi_bkpt);
+            multi_bkpt = multi_bkpt->next;
+        }
+    }
+
+    return locations;
+}
+
+static void tgdb_breakpoints_free(struct tgdb_breakpoint *breakpoints)
+{
+    // The paths are interned
+    sbfree(breakpoints);
+}
+
+/**
+ * Append a copy of a breakpoint location to a list.
+ */
+static void tgdb_breakpoint_append(struct tgdb_breakpoint *&dest,
+        const struct tgdb_breakpoint &location)
+{
+    sbpush(dest, location);
+}
+
+static void tgdb_breakpoints_append(struct tgdb_breakpoint *&dest,
+        struct tgdb_breakpoint *src)
+{
+    int i;
+
+    for (i = 0; i < sbcount(src); i++) {
+        tgdb_breakpoint_append(dest, src[i]);
+    }
+}
+
+/**
+ * Determine if two breakpoint locations mark the same source or
+ * disassembly line.
+ */
+static bool tgdb_breakpoint_same_line(const struct tgdb_breakpoint &lhs,
+        const struct tgdb_breakpoint &rhs)
+{
+    if (lhs.addr && lhs.addr == rhs.addr) {
+        return true;
+    }
+
+    return lhs.path && lhs.path == rhs.path && lhs.line == rhs.line;
+}
+
+static bool tgdb_breakpoints_equal(struct tgdb_breakpoint *lhs,
+        struct tgdb_breakpoint *rhs)
+{
+    int i;
+
+    if (sbcount(lhs) != sbcount(rhs)) {
+        return false;
+    }
+
+    for (i = 0; i < sbcount(lhs); i++) {
+        if (lhs[i].line != rhs[i].line || lhs[i].addr != rhs[i].addr ||
+            lhs[i].enabled != rhs[i].enabled || lhs[i].path != rhs[i].path) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void tgdb_breakpoint_map_clear(tgdb_breakpoint_map *map)
+{
+    tgdb_breakpoint_map::iterator iter = map->begin();
+    for (; iter != map->end(); ++iter) {
+        tgdb_breakpoints_free(iter->second);
+    }
+
+    map->clear();
+}
+
+static void tgdb_breakpoint_table_clear(struct tgdb *tgdb)
+{
+    tgdb_breakpoint_map_clear(tgdb->breakpoints);
+}
+
+/**
+ * Add a row of the -break-info breakpoint table to a breakpoints request.
+ *
+ * gdbwire streams the rows of the table one at a time, so they are
+ * converted as they arrive. The locations of a multiple location
+ * breakpoint follow it as rows of their own.
+ */
+static void tgdb_breakpoints_add_row(struct tgdb *tgdb,
+        struct tgdb_request *request, struct gdbwire_mi_result *row)
+{
+    struct gdbwire_mi_command *mi_command = 0;
+    struct gdbwire_mi_breakpoint *breakpoint;
+
+    if (request->choice.breakpoints.error) {
+        return;
+    }
+
+    if (row->kind != GDBWIRE_MI_TUPLE ||
+            gdbwire_get_mi_breakpoint(row, &mi_command) != GDBWIRE_OK) {
+        request->choice.breakpoints.error = true;
+        return;
+    }
+
+    breakpoint = mi_command->variant.break_info.breakpoints;
+
+    if (!request->choice.breakpoints.table) {
+        request->choice.breakpoints.table = new tgdb_breakpoint_map();
+    }
+
+    if (breakpoint->from_multi) {
+        // A location can only follow its breakpoint
+        if (!request->choice.breakpoints.number_set) {
+            request->choice.breakpoints.error = true;
+        } else if (request->choice.breakpoints.multi) {
+            struct tgdb_breakpoint *&locations =
+                (*request->choice.breakpoints.table)[
+                    request->choice.breakpoints.number];
+            int count = sbcount(locations);
+
+            tgdb_commands_process_breakpoint(tgdb, locations, breakpoint);
+            if (sbcount(locations) > count) {
+                tgdb_breakpoint_append(request->choice.breakpoints.breakpoints,
+                        locations[count]);
+            }
+        }
+    } else {
+        struct tgdb_breakpoint *locations =
+            tgdb_breakpoint_locations(tgdb, breakpoint);
+        int number = atoi(breakpoint->number);
+        tgdb_breakpoint_map::iterator iter =
+            request->choice.breakpoints.table->find(number);
+
+        if (iter != request->choice.breakpoints.table->end()) {
+            tgdb_breakpoints_free(iter->second);
+        }
+
+        tgdb_breakpoints_append(request->choice.breakpoints.breakpoints,
+                locations);
+        (*request->choice.breakpoints.table)[number] = locations;
+
+        request->choice.breakpoints.number = number;
+        request->choice.breakpoints.multi = breakpoint->multi;
+        request->choice.breakpoints.number_set = true;
+    }
+
+    gdbwire_mi_command_free(mi_command);
+}
+
+static void tgdb_commands_process_breakpoints(struct tgdb *tgdb,
+        struct tgdb_request *request,
+        struct gdbwire_mi_result_record *result_record)
+{
+    enum gdbwire_result result;
+    struct gdbwire_mi_command *mi_command = 0;
+
+    // The rows of the table were converted as gdbwire streamed them,
+    // this checks the rest of the table
+    result = gdbwire_get_mi_command(GDBWIRE_MI_BREAK_INFO,
+        result_record, &mi_command);
+    if (result == GDBWIRE_OK) {
+        if (!request->choice.breakpoints.error) {
+            tgdb_breakpoint_table_clear(tgdb);
+
+            if (request->choice.breakpoints.table) {
+                tgdb->breakpoints->swap(*request->choice.breakpoints.table);
+            }
+
+            tgdb_commands_send_breakpoints(tgdb,
+                    request->choice.breakpoints.breakpoints);
+            request->choice.breakpoints.breakpoints = NULL;
+        }
+
+        gdbwire_mi_command_free(mi_command);
+    }
+}
+
+/**
+ * Update a single breakpoint in the breakpoint table and tell the front
+ * end what changed.
+ *
+ * @param tgdb
+ * The tgdb instance
+ *
+ * @param number
+ * The breakpoint number
+ *
+ * @param locations
+ * The new locations of the breakpoint, owned by the table afterwards.
+ * NULL if the breakpoint was deleted or has no displayable locations.
+ */
+static void tgdb_commands_change_breakpoint(struct tgdb *tgdb, int number,
+        struct tgdb_breakpoint *locations)
+{
+    tgdb_breakpoint_map::iterator iter = tgdb->breakpoints->find(number);
+    struct tgdb_breakpoint *old_locations = NULL;
+    struct tgdb_breakpoint *removed = NULL, *added = NULL;
+    struct tgdb_response *response;
+    int i;
+
+    if (iter != tgdb->breakpoints->end()) {
+        old_locations = iter->second;
+        tgdb->breakpoints->erase(iter);
+    }
+
+    if (locations) {
+        (*tgdb->breakpoints)[number] = locations;
+    }
+
+    // Hit counts and conditions change without affecting what is shown
+    if (tgdb_breakpoints_equal(old_locations, locations)) {
+        tgdb_breakpoints_free(old_locations);
+        return;
+    }
+
+    tgdb_breakpoints_append(removed, old_locations);
+    tgdb_breakpoints_append(added, locations);
+
+    // Keep lines marked that another breakpoint still sits on
+    for (i = 0; i < sbcount(old_locations); i++) {
+        bool found = false;
+        for (iter = tgdb->breakpoints->begin();
+                !found && iter != tgdb->breakpoints->end(); ++iter) {
+            struct tgdb_breakpoint *other = iter->second;
+            int j;
+
+            if (iter->first == number) {
+                continue;
+            }
+
+            for (j = 0; j < sbcount(other); j++) {
+                if (tgdb_breakpoint_same_line(old_locations[i], other[j])) {
+                    tgdb_breakpoint_append(added, other[j]);
+                    found = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    tgdb_breakpoints_free(old_locations);
+
+    response = tgdb_create_response(tgdb, TGDB_UPDATE_BREAKPOINT_CHANGES);
+    response->choice.update_breakpoint_changes.removed = removed;
+    response->choice.update_breakpoint_changes.added = added;
+    tgdb_send_response(tgdb, response);
+}
+
+void tgdb_breakpoints_changed(void *context);
+
+/**
+ * Apply a =breakpoint-created, =breakpoint-modified or =breakpoint-deleted
+ * async record to the breakpoint table.
+ *
+ * If the record can not be understood, the entire breakpoint list is
+ * requested from gdb instead.
+ */
+static void tgdb_commands_process_breakpoint_async_record(struct tgdb *tgdb,
+        struct gdbwire_mi_async_record *async_record)
+{
+    struct gdbwire_mi_result *result = async_record->result;
+
+    if (async_record->async_class == GDBWIRE_MI_ASYNC_BREAKPOINT_DELETED) {
+        for (; result; result = result->next) {
+            if (result->kind == GDBWIRE_MI_CSTRING &&
+                    strcmp(result->variable, "id") == 0) {
+                tgdb_commands_change_breakpoint(tgdb,
+                        atoi(result->variant.cstring), NULL);
+                return;
+            }
+        }
+    } else {
+        struct gdbwire_mi_command *mi_command = 0;
+        if (result &&
+                gdbwire_get_mi_breakpoint(result, &mi_command) == GDBWIRE_OK) {
+            struct gdbwire_mi_breakpoint *breakpoint =
+                mi_command->variant.break_info.breakpoints;
+            tgdb_commands_change_breakpoint(tgdb, atoi(breakpoint->number),
+                    tgdb_breakpoint_locations(tgdb, breakpoint));
+            gdbwire_mi_command_free(mi_command);
+            return;
+        }
+    }
+
+    tgdb_breakpoints_changed(tgdb);
+}
+
+static void tgdb_source_files_free(const char **source_files)
+{
+    // The files are interned
+    sbfree(source_files);
+}
+
+/**
+ * Send a copy of the cached source file list to the front end.
+ */
+static void tgdb_commands_send_source_files(struct tgdb *tgdb)
+{
+    struct tgdb_response *response =
+        tgdb_create_response(tgdb, TGDB_UPDATE_SOURCE_FILES);
+    const char **source_files = NULL;
+    int i;
+
+    for (i = 0; i < sbcount(tgdb->source_files); i++) {
+        sbpush(source_files, tgdb->source_files[i]);
+    }
+
+    tgdb->source_files_wanted = false;
+
+    response->choice.update_source_files.source_files = source_files;
+    tgdb_send_response(tgdb, response);
+}
+
+// The fields of a file of -file-list-exec-source-files
+enum tgdb_source_file_field {
+    TGDB_SOURCE_FILE_FILE,
+    TGDB_SOURCE_FILE_FULLNAME,
+    TGDB_SOURCE_FILE_FIELDS
+};
+
+static const char *const tgdb_source_file_fields[] = {
+    "file",
+    "fullname"
+};
+
+static struct gdbwire_mi_schema tgdb_source_file_schema =
+    GDBWIRE_MI_SCHEMA(tgdb_source_file_fields);
+
+/**
+ * Add a file of -file-list-exec-source-files to a source files request.
+ *
+ * gdbwire streams the files one at a time, so they are converted as
+ * they arrive.
+ */
+static void tgdb_source_files_add(struct tgdb *tgdb,
+        struct tgdb_request *request, struct gdbwire_mi_result *file)
+{
+    char *fields[TGDB_SOURCE_FILE_FIELDS];
+
+    // As in gdbwire's conversion, a file is a tuple of strings naming it
+    if (file->kind != GDBWIRE_MI_TUPLE ||
+            gdbwire_mi_schema_extract(&tgdb_source_file_schema,
+                file->variant.result, fields) != 0 ||
+            !fields[TGDB_SOURCE_FILE_FILE]) {
+        request->choice.info_sources.error = true;
+        return;
+    }
+
+    sbpush(request->choice.info_sources.source_files,
+            tgdb_intern(tgdb, fields[TGDB_SOURCE_FILE_FULLNAME] ?
+                fields[TGDB_SOURCE_FILE_FULLNAME] :
+                fields[TGDB_SOURCE_FILE_FILE]));
+}
+
+/* This function is capable of parsing the output of 'info source'.
+ * It can get both the absolute and relative path to the source file.
+ *
+ * The list replaces the cached one. It is only passed on to the front end
+ * if the front end is waiting for it.
+ */
+static void
+tgdb_commands_process_info_sources(struct tgdb *tgdb,
+        struct tgdb_request *request,
+        struct gdbwire_mi_result_record *result_record)
+{
+    enum gdbwire_result result;
+    struct gdbwire_mi_command *mi_command = 0;
+    const char **source_files = NULL;
+
+    // An error means gdb has no symbols loaded, so there are no files.
+    // The files themselves were converted as gdbwire streamed them.
+    result = gdbwire_get_mi_command(GDBWIRE_MI_FILE_LIST_EXEC_SOURCE_FILES,
+        result_record, &mi_command);
+    if (result == GDBWIRE_OK) {
+        if (!request->choice.info_sources.error) {
+            source_files = request->choice.info_sources.source_files;
+            request->choice.info_sources.source_files = NULL;
+        }
+
+        gdbwire_mi_command_free(mi_command);
+    }
+
+    tgdb_source_files_free(tgdb->source_files);
+    tgdb->source_files = source_files;
+    tgdb->source_files_valid = !tgdb->source_files_stale;
+
+    if (tgdb->source_files_wanted) {
+        tgdb_commands_send_source_files(tgdb);
+    }
+}
+
+/**
+ * The -data-disassemble mode tgdb always asks for.
+ *
+ * Raw opcodes are always requested since they give the size of each
+ * instruction. That is what lets the cache tell which ranges are adjacent.
+ * Source lines are included when gdb supports source centric mode.
+ */
+static int tgdb_disassemble_mode(struct tgdb *tgdb)
+{
+    return tgdb->disassemble_supports_s_mode ? 5 : 2;
+}
+
+/**
+ * Get the size in bytes of an instruction from its raw opcodes.
+ *
+ * GDB prints the opcodes as hex bytes or words separated by spaces,
+ * for instance "48 89 e5".
+ */
+static uint64_t tgdb_disasm_opcodes_size(const char *opcodes)
+{
+    uint64_t digits = 0;
+
+    for (; *opcodes; ++opcodes) {
+        if (isxdigit((unsigned char)*opcodes)) {
+            ++digits;
+        }
+    }
+
+    return digits / 2;
+}
+
+// The fields of an instruction tuple of -data-disassemble
+enum tgdb_insn_field {
+    TGDB_INSN_ADDRESS,
+    TGDB_INSN_FUNC_NAME,
+    TGDB_INSN_OFFSET,
+    TGDB_INSN_OPCODES,
+    TGDB_INSN_INST,
+    TGDB_INSN_FIELDS
+};
+
+static const char *const tgdb_insn_fields[] = {
+    "address",
+    "func-name",
+    "offset",
+    "opcodes",
+    "inst"
+};
+
+static struct gdbwire_mi_schema tgdb_insn_schema =
+    GDBWIRE_MI_SCHEMA(tgdb_insn_fields);
+
+// The fields of a src_and_asm_line tuple of -data-disassemble
+enum tgdb_insn_source_field {
+    TGDB_INSN_SOURCE_LINE,
+    TGDB_INSN_SOURCE_FILE,
+    TGDB_INSN_SOURCE_FULLNAME,
+    TGDB_INSN_SOURCE_FIELDS
+};
+
+static const char *const tgdb_insn_source_fields[] = {
+    "line",
+    "file",
+    "fullname"
+};
+
+static struct gdbwire_mi_schema tgdb_insn_source_schema =
+    GDBWIRE_MI_SCHEMA(tgdb_insn_source_fields);
+
+/**
+ * Add an instruction tuple from the asm_insns list to the cache.
+ *
+ * @param tgdb
+ * The tgdb instance
+ *
+ * @param result
+ * The results of the instruction tuple
+ *
+ * @param source
+ * The src_and_asm_line tuple the instruction was listed under, or NULL
+ *
+ * @param whole_function
+ * True if the instruction was disassembled as part of its whole function
+ */
+static void tgdb_disasm_cache_add_insn(struct tgdb *tgdb,
+        struct gdbwire_mi_result *result, struct gdbwire_mi_result *source,
+        bool whole_function)
+{
+    struct tgdb_disasm_insn insn;
+    char *fields[TGDB_INSN_FIELDS];
+    char *source_fields[TGDB_INSN_SOURCE_FIELDS];
+    uint64_t address = 0;
+
+    gdbwire_mi_schema_extract(&tgdb_insn_schema, result, fields);
+
+    if (!fields[TGDB_INSN_ADDRESS] ||
+            cgdb_hexstr_to_u64(fields[TGDB_INSN_ADDRESS], &address) != 0) {
+        return;
+    }
+
+    insn.size = 0;
+    insn.address_digits = (int)strlen(fields[TGDB_INSN_ADDRESS]) - 2;
+    insn.line = 0;
+    insn.whole_function = whole_function;
+
+    if (fields[TGDB_INSN_FUNC_NAME]) {
+        insn.func = fields[TGDB_INSN_FUNC_NAME];
+    }
+    if (fields[TGDB_INSN_OFFSET]) {
+        insn.offset = fields[TGDB_INSN_OFFSET];
+    }
+    if (fields[TGDB_INSN_OPCODES]) {
+        insn.opcodes = fields[TGDB_INSN_OPCODES];
+        insn.size = tgdb_disasm_opcodes_size(fields[TGDB_INSN_OPCODES]);
+    }
+    if (fields[TGDB_INSN_INST]) {
+        insn.inst = fields[TGDB_INSN_INST];
+    }
+
+    if (source) {
+        gdbwire_mi_schema_extract(&tgdb_insn_source_schema, source,
+                source_fields);
+
+        if (source_fields[TGDB_INSN_SOURCE_LINE]) {
+            insn.line = atoi(source_fields[TGDB_INSN_SOURCE_LINE]);
+        }
+        if (source_fields[TGDB_INSN_SOURCE_FILE]) {
+            insn.file = source_fields[TGDB_INSN_SOURCE_FILE];
+        }
+        if (source_fields[TGDB_INSN_SOURCE_FULLNAME]) {
+            insn.fullname = source_fields[TGDB_INSN_SOURCE_FULLNAME];
+        }
+    }
+
+    std::pair<tgdb_disasm_cache::iterator, bool> inserted =
+        tgdb->disasm_cache->insert(std::make_pair(address, insn));
+
+    // Knowing the whole function is sticky. Anything else gdb says about
+    // an instruction is the same no matter how it was asked.
+    if (!inserted.second && whole_function) {
+        inserted.first->second.whole_function = true;
+    }
+}
+
+/**
+ * Add the instructions of a -data-disassemble result record to the cache.
+ *
+ * The asm_insns list either holds instruction tuples or, in the source
+ * centric modes, src_and_asm_line tuples that each hold a line_asm_insn
+ * list of instruction tuples.
+ */
+static void tgdb_disasm_cache_add(struct tgdb *tgdb,
+        struct gdbwire_mi_result_record *result_record, bool whole_function)
+{
+    struct gdbwire_mi_result *result = result_record->result;
+
+    for (; result; result = result->next) {
+        if (result->kind == GDBWIRE_MI_LIST &&
+                strcmp(result->variable, "asm_insns") == 0) {
+            break;
+        }
+    }
+
+    if (!result) {
+        return;
+    }
+
+    for (result = result->variant.result; result; result = result->next) {
+        struct gdbwire_mi_result *item, *line_insns = NULL;
+
+        if (result->kind != GDBWIRE_MI_TUPLE) {
+            continue;
+        }
+
+        for (item = result->variant.result; item; item = item->next) {
+            if (item->kind == GDBWIRE_MI_LIST &&
+                    strcmp(item->variable, "line_asm_insn") == 0) {
+                line_insns = item;
+                break;
+            }
+        }
+
+        if (line_insns) {
+            for (item = line_insns->variant.result; item; item = item->next) {
+                if (item->kind == GDBWIRE_MI_TUPLE) {
+                    tgdb_disasm_cache_add_insn(tgdb, item->variant.result,
+                            result->variant.result, whole_function);
+                }
+            }
+        } else {
+            tgdb_disasm_cache_add_insn(tgdb, result->variant.result, NULL,
+                    whole_function);
+        }
+    }
+}
+
+/**
+ * Determine if the instruction after ITER in the cache directly follows it
+ * in memory.
+ */
+static bool tgdb_disasm_cache_contiguous(struct tgdb *tgdb,
+        tgdb_disasm_cache::iterator iter)
+{
+    tgdb_disasm_cache::iterator next = iter;
+
+    if (++next == tgdb->disasm_cache->end()) {
+        return false;
+    }
+
+    return iter->second.size && iter->first + iter->second.size == next->first;
+}
+
+/**
+ * Find the cached instruction that starts at ADDR.
+ *
+ * @return
+ * The instruction or the end of the cache if it is not there.
+ */
+static tgdb_disasm_cache::iterator tgdb_disasm_cache_find(struct tgdb *tgdb,
+        uint64_t addr)
+{
+    return tgdb->disasm_cache->find(addr);
+}
+
+static void tgdb_send_disassemble_error(struct tgdb *tgdb,
+        enum tgdb_response_type type, uint64_t addr)
+{
+    struct tgdb_response *response = tgdb_create_response(tgdb, type);
+
+    response->choice.disassemble_function.error = 1;
+    response->choice.disassemble_function.addr_start = addr;
+
+    tgdb_send_response(tgdb, response);
+}
+
+/**
+ * Get the lines of a source file for source centric disassembly.
+ *
+ * The file is read the first time it is asked for and then kept with
+ * the disassembly cache, so a dump reads each of its files once.
+ *
+ * @param path
+ * The file to read
+ *
+ * @return
+ * The lines of the file without their newlines, or no lines if the
+ * file could not be read.
+ */
+static const std::vector<std::string> &
+tgdb_disasm_source_lines(struct tgdb *tgdb, const std::string &path)
+{
+    tgdb_disasm_sources::iterator iter = tgdb->disasm_sources->find(path);
+    FILE *file;
+    char buf[4096];
+    bool eol = true;
+
+    if (iter != tgdb->disasm_sources->end()) {
+        return iter->second;
+    }
+
+    std::vector<std::string> &lines = (*tgdb->disasm_sources)[path];
+
+    file = path.empty() ? NULL : fopen(path.c_str(), "r");
+    if (!file) {
+        return lines;
+    }
+
+    while (fgets(buf, sizeof (buf), file)) {
+        size_t length = strlen(buf);
+
+        // A line longer than buf continues the previous one
+        if (eol) {
+            lines.push_back(std::string());
+        }
+
+        eol = length && buf[length - 1] == '\n';
+        lines.back().append(buf, eol ? length - 1 : length);
+    }
+
+    fclose(file);
+    return lines;
+}
+
+/**
+ * Forget every disassembled instruction and the source lines read
+ * for them.
+ */
+static void tgdb_disasm_cache_clear(struct tgdb *tgdb)
+{
+    tgdb->disasm_cache->clear();
+    tgdb->disasm_sources->clear();
+}
+
+/**
+ * Send a function's worth of disassembly from the cache.
+ *
+ * The lines look like the output of the gdb disassemble command.
+ *
+ * @param tgdb
+ * The tgdb instance
+ *
+ * @param addr
+ * An address in the function
+ *
+ * @param source
+ * Include the source lines the instructions were generated from
+ *
+ * @param raw
+ * Include the raw opcodes of the instructions
+ *
+ * @return
+ * True if the whole function was in the cache and was sent.
+ */
+static bool tgdb_send_disassemble_func(struct tgdb *tgdb, uint64_t addr,
+        int source, int raw)
+{
+    tgdb_disasm_cache::iterator first = tgdb_disasm_cache_find(tgdb, addr);
+    tgdb_disasm_cache::iterator last = first;
+    tgdb_disasm_cache::iterator iter;
+    struct tgdb_response *response;
+    char **disasm = NULL;
+    std::string file;
+    int line = 0;
+
+    if (first == tgdb->disasm_cache->end() || !first->second.whole_function) {
+        return false;
+    }
+
+    const std::string &func = first->second.func;
+
+    while (first != tgdb->disasm_cache->begin()) {
+        iter = first;
+        --iter;
+        if (!tgdb_disasm_cache_contiguous(tgdb, iter) ||
+                iter->second.func != func) {
+            break;
+        }
+        first = iter;
+    }
+
+    while (tgdb_disasm_cache_contiguous(tgdb, last)) {
+        iter = last;
+        ++iter;
+        if (iter->second.func != func) {
+            break;
+        }
+        last = iter;
+    }
+
+    sbpush(disasm, sys_aprintf("Dump of assembler code for function %s:",
+            func.c_str()));
+
+    for (iter = first;; ++iter) {
+        const struct tgdb_disasm_insn &insn = iter->second;
+
+        if (source && insn.line &&
+                (insn.line != line || insn.file != file)) {
+            if (insn.file != file) {
+                sbpush(disasm, sys_aprintf("%s:", insn.file.c_str()));
+            }
+            const std::vector<std::string> &lines =
+                tgdb_disasm_source_lines(tgdb, insn.fullname);
+            sbpush(disasm, sys_aprintf("%d\t%s", insn.line,
+                    insn.line > 0 && insn.line <= (int)lines.size() ?
+                    lines[insn.line - 1].c_str() : ""));
+            file = insn.file;
+            line = insn.line;
+        }
+
+        if (raw) {
+            sbpush(disasm, sys_aprintf("   0x%0*" PRIx64 " <+%s>:\t%s\t%s",
+                    insn.address_digits, iter->first, insn.offset.c_str(),
+                    insn.opcodes.c_str(), insn.inst.c_str()));
+        } else {
+            sbpush(disasm, sys_aprintf("   0x%0*" PRIx64 " <+%s>:\t%s",
+                    insn.address_digits, iter->first, insn.offset.c_str(),
+                    insn.inst.c_str()));
+        }
+
+        if (iter == last) {
+            break;
+        }
+    }
+
+    sbpush(disasm, cgdb_strdup("End of assembler dump."));
+
+    response = tgdb_create_response(tgdb, TGDB_DISASSEMBLE_FUNC);
+    response->choice.disassemble_function.disasm = disasm;
+    response->choice.disassemble_function.addr_start = first->first;
+    response->choice.disassemble_function.addr_end = last->first;
+    tgdb_send_response(tgdb, response);
+
+    return true;
+}
+
+/**
+ * Send disassembly starting at an address from the cache.
+ *
+ * The lines look like the output of the gdb x/i command.
+ *
+ * @param tgdb
+ * The tgdb instance
+ *
+ * @param addr
+ * The address to start at
+ *
+ * @param lines
+ * The number of instructions to send
+ *
+ * @param partial
+ * If true, send however many contiguous instructions are cached,
+ * otherwise only send if all LINES instructions are.
+ *
+ * @return
+ * True if the disassembly was sent.
+ */
+static bool tgdb_send_disassemble_pc(struct tgdb *tgdb, uint64_t addr,
+        int lines, bool partial)
 {
-    struct tgdb_response *response = (struct tgdb_response *)
-        tgdb_create_response(TGDB_UPDATE_BREAKPOINTS);
+    tgdb_disasm_cache::iterator first = tgdb_disasm_cache_find(tgdb, addr);
+    tgdb_disasm_cache::iterator iter = first;
+    struct tgdb_response *response;
+    char **disasm = NULL;
+    uint64_t addr_end;
+    int count = 1;
 
-    response->choice.update_breakpoints.breakpoints = breakpoints;
+    if (first == tgdb->disasm_cache->end()) {
+        return false;
+    }
 
-    tgdb_send_response(tgdb, response);
-}
+    while (count < lines && tgdb_disasm_cache_contiguous(tgdb, iter)) {
+        ++iter;
+        ++count;
+    }
 
-static void tgdb_commands_process_breakpoint(
-        struct tgdb_breakpoint *&breakpoints,
-        struct gdbwire_mi_breakpoint *breakpoint)
-{
-    bool file_location_avialable =
-        (breakpoint->fullname || breakpoint->file) && breakpoint->line != 0;
-    bool assembly_location_available = breakpoint->address && 
-        !breakpoint->pending && !breakpoint->multi;
+    if (count < lines && !partial) {
+        return false;
+    }
 
-    if (file_location_avialable || assembly_location_available) {
-        struct tgdb_breakpoint tb;
+    addr_end = iter->first;
 
-        if (file_location_avialable) {
-            tb.path = (breakpoint->fullname)?
-                cgdb_strdup(breakpoint->fullname):
-                cgdb_strdup(breakpoint->file);
-            tb.line = breakpoint->line;
-        } else {
-            tb.path = 0;
-            tb.line = 0;
-        }
+    for (iter = first, count = 0; count < lines; ++iter, ++count) {
+        const struct tgdb_disasm_insn &insn = iter->second;
 
-        if (assembly_location_available) {
-            uint64_t address = 0;
-            cgdb_hexstr_to_u64(breakpoint->address, &address);
-            tb.addr = address;
+        if (insn.func.empty()) {
+            sbpush(disasm, sys_aprintf("   0x%" PRIx64 ":\t%s",
+                    iter->first, insn.inst.c_str()));
+        } else if (insn.offset == "0") {
+            sbpush(disasm, sys_aprintf("   0x%" PRIx64 " <%s>:\t%s",
+                    iter->first, insn.func.c_str(), insn.inst.c_str()));
         } else {
-            tb.addr = 0;
+            sbpush(disasm, sys_aprintf("   0x%" PRIx64 " <%s+%s>:\t%s",
+                    iter->first, insn.func.c_str(), insn.offset.c_str(),
+                    insn.inst.c_str()));
         }
 
-        tb.enabled = breakpoint->enabled;
-        sbpush(breakpoints, tb);
+        if (iter->first == addr_end) {
+            break;
+        }
     }
+
+    response = tgdb_create_response(tgdb, TGDB_DISASSEMBLE_PC);
+    response->choice.disassemble_function.disasm = disasm;
+    response->choice.disassemble_function.addr_start = first->first;
+    response->choice.disassemble_function.addr_end = addr_end;
+    tgdb_send_response(tgdb, response);
+
+    return true;
 }
 
-static void tgdb_commands_process_breakpoints(struct tgdb *tgdb,
-        struct gdbwire_mi_result_record *result_record)
+/**
+ * Keep a line printed by the CLI disassemble command.
+ *
+ * When gdb's -data-disassemble does not support -a, functions are
+ * disassembled with the CLI disassemble command instead. Its lines come
+ * as console stream records, which carry no token. So the command is run
+ * alone, and every console stream record until its result record is
+ * one of its lines.
+ *
+ * @param tgdb
+ * The tgdb instance
+ *
+ * @param line
+ * The text of the console stream record
+ */
+static void tgdb_disassemble_cli_line(struct tgdb *tgdb, const char *line)
 {
-    enum gdbwire_result result;
-    struct gdbwire_mi_command *mi_command = 0;
-    result = gdbwire_get_mi_command(GDBWIRE_MI_BREAK_INFO,
-        result_record, &mi_command);
-    if (result == GDBWIRE_OK) {
-        struct tgdb_breakpoint *breakpoints = NULL;
-        struct gdbwire_mi_breakpoint *breakpoint =
-            mi_command->variant.break_info.breakpoints;
-        while (breakpoint) {
-            tgdb_commands_process_breakpoint(breakpoints, breakpoint);
-
-            if (breakpoint->multi) {
-                struct gdbwire_mi_breakpoint *multi_bkpt =
-                    breakpoint->multi_breakpoints;
-                while (multi_bkpt) {
-                    tgdb_commands_process_breakpoint(breakpoints, multi_bkpt);
-                    multi_bkpt = multi_bkpt->next;
-                }
-            }
+    char *str = cgdb_strdup(line);
+    size_t length = strlen(str);
+    char *colon;
+    uint64_t address;
+    int result;
 
-            breakpoint = breakpoint->next;
-        }
+    if (length && str[length - 1] == '\n') {
+        str[length - 1] = 0;
+    }
 
-        tgdb_commands_send_breakpoints(tgdb, breakpoints);
+    /* Trim the gdb current location pointer off */
+    if (str[0] == '=' && str[1] == '>') {
+        str[0] = ' ';
+        str[1] = ' ';
+    }
 
-        gdbwire_mi_command_free(mi_command);
+    sbpush(tgdb->cli_disasm, str);
+
+    colon = strchr(str, ':');
+    if (colon) {
+        *colon = 0;
     }
-}
 
-static void tgdb_commands_send_source_files(struct tgdb *tgdb,
-        char **source_files)
-{
-    struct tgdb_response *response =
-        tgdb_create_response(TGDB_UPDATE_SOURCE_FILES);
-    response->choice.update_source_files.source_files = source_files;
-    tgdb_send_response(tgdb, response);
+    result = cgdb_hexstr_to_u64(str, &address);
+
+    if (colon) {
+        *colon = ':';
+    }
+
+    if (result == 0 && address) {
+        tgdb->cli_disasm_start = tgdb->cli_disasm_start ?
+            MIN(address, tgdb->cli_disasm_start) : address;
+        tgdb->cli_disasm_end = MAX(address, tgdb->cli_disasm_end);
+    }
 }
 
-/* This function is capable of parsing the output of 'info source'.
- * It can get both the absolute and relative path to the source file.
+/**
+ * Send the lines the CLI disassemble command printed.
+ *
+ * @param tgdb
+ * The tgdb instance
+ *
+ * @param done
+ * True if the command succeeded
+ *
+ * @return
+ * True if the disassembly was sent.
  */
-static void
-tgdb_commands_process_info_sources(struct tgdb *tgdb,
-        struct gdbwire_mi_result_record *result_record)
+static bool tgdb_send_disassemble_cli(struct tgdb *tgdb, bool done)
 {
-    enum gdbwire_result result;
-    struct gdbwire_mi_command *mi_command = 0;
-    result = gdbwire_get_mi_command(GDBWIRE_MI_FILE_LIST_EXEC_SOURCE_FILES,
-        result_record, &mi_command);
-    if (result == GDBWIRE_OK) {
-        char **source_files = NULL;
-        struct gdbwire_mi_source_file *files =
-            mi_command->variant.file_list_exec_source_files.files;
-        while (files) {
-            char *file = (files->fullname)?files->fullname:files->file;
-            sbpush(source_files, strdup(file));
-            files = files->next;
+    struct tgdb_response *response;
+    char **disasm = tgdb->cli_disasm;
+    bool sent = done && tgdb->cli_disasm_start;
+    int i;
+
+    if (sent) {
+        response = tgdb_create_response(tgdb, TGDB_DISASSEMBLE_FUNC);
+        response->choice.disassemble_function.disasm = disasm;
+        response->choice.disassemble_function.addr_start =
+            tgdb->cli_disasm_start;
+        response->choice.disassemble_function.addr_end =
+            tgdb->cli_disasm_end;
+        tgdb_send_response(tgdb, response);
+    } else {
+        for (i = 0; i < sbcount(disasm); i++) {
+            free(disasm[i]);
         }
+        sbfree(disasm);
+    }
 
-        tgdb_commands_send_source_files(tgdb, source_files);
+    tgdb->cli_disassembling = false;
+    tgdb->cli_disasm = NULL;
+    tgdb->cli_disasm_start = 0;
+    tgdb->cli_disasm_end = 0;
 
-        gdbwire_mi_command_free(mi_command);
-    }
+    return sent;
 }
 
 static void send_disassemble_func_complete_response(struct tgdb *tgdb,
+        tgdb_request_ptr request,
         struct gdbwire_mi_result_record *result_record)
 {
-    tgdb_response_type type =
-            (tgdb->current_request_type == TGDB_REQUEST_DISASSEMBLE_PC) ?
-                TGDB_DISASSEMBLE_PC : TGDB_DISASSEMBLE_FUNC;
-    struct tgdb_response *response =
-        tgdb_create_response(type);
-
-    response->choice.disassemble_function.error = 
-        (result_record->result_class == GDBWIRE_MI_ERROR);
-            
-    response->choice.disassemble_function.disasm = tgdb->disasm;
-    response->choice.disassemble_function.addr_start = tgdb->address_start;
-    response->choice.disassemble_function.addr_end = tgdb->address_end;
-    
-    tgdb->disasm = NULL;
-    tgdb->address_start = 0;
-    tgdb->address_end = 0;
+    bool sent = false;
+
+    if (tgdb->cli_disassembling) {
+        sent = tgdb_send_disassemble_cli(tgdb,
+                result_record->result_class == GDBWIRE_MI_DONE);
+    } else if (result_record->result_class == GDBWIRE_MI_DONE) {
+        if (request->header == TGDB_REQUEST_DISASSEMBLE_PC) {
+            tgdb_disasm_cache_add(tgdb, result_record, false);
+            sent = tgdb_send_disassemble_pc(tgdb,
+                    request->choice.disassemble.addr,
+                    request->choice.disassemble.lines, true);
+        } else {
+            tgdb_disasm_cache_add(tgdb, result_record, true);
+            sent = tgdb_send_disassemble_func(tgdb,
+                    request->choice.disassemble_func.addr,
+                    request->choice.disassemble_func.source,
+                    request->choice.disassemble_func.raw);
+        }
+    }
 
-    tgdb_send_response(tgdb, response);
+    if (!sent) {
+        if (request->header == TGDB_REQUEST_DISASSEMBLE_PC) {
+            tgdb_send_disassemble_error(tgdb, TGDB_DISASSEMBLE_PC,
+                    request->choice.disassemble.addr);
+        } else {
+            tgdb_send_disassemble_error(tgdb, TGDB_DISASSEMBLE_FUNC,
+                    request->choice.disassemble_func.addr);
+        }
+    }
 }
 
 static void
@@ -312,26 +2012,20 @@ tgdb_commands_send_source_file(struct tgdb *tgdb, const char *fullname,
         const char *file, uint64_t address, const char *from,
         const char *func, int line)
 {
-    /* This section allocates a new structure to add into the queue 
-     * All of its members will need to be freed later.
+    /* The file position comes with the response and its strings are
+     * interned, so nothing is allocated once they have been seen.
      */
-    struct tgdb_file_position *tfp = (struct tgdb_file_position *)
-            cgdb_malloc(sizeof (struct tgdb_file_position));
     struct tgdb_response *response =
-            tgdb_create_response(TGDB_UPDATE_FILE_POSITION);
+            tgdb_create_response(tgdb, TGDB_UPDATE_FILE_POSITION);
+    struct tgdb_file_position *tfp =
+            response->choice.update_file_position.file_position;
 
-    if (fullname || file) {
-        tfp->path = (fullname)?cgdb_strdup(fullname):cgdb_strdup(file);
-    } else {
-        tfp->path = 0;
-    }
+    tfp->path = tgdb_intern(tgdb, (fullname)?fullname:file);
     tfp->addr = address;
-    tfp->from = (from)?cgdb_strdup(from):0;
-    tfp->func = (func)?cgdb_strdup(func):0;
+    tfp->from = tgdb_intern(tgdb, from);
+    tfp->func = tgdb_intern(tgdb, func);
     tfp->line_number = line;
 
-    response->choice.update_file_position.file_position = tfp;
-
     tgdb_send_response(tgdb, response);
 }
 
@@ -381,117 +2075,148 @@ static void tgdb_commands_process_info_frame(struct tgdb *tgdb,
 
     if (require_source) {
         tgdb_request_ptr request;
-        request = (tgdb_request_ptr) cgdb_malloc(sizeof (struct tgdb_request));
-        request->header = TGDB_REQUEST_INFO_SOURCE_FILE;
-        tgdb_run_or_queue_request(tgdb, request, true);
+        request = tgdb_request_create(tgdb, TGDB_REQUEST_INFO_SOURCE_FILE);
+        tgdb_run_or_queue_request(tgdb, request, TGDB_PRIORITY_STATE);
     }
 }
 
-static void gdbwire_stream_record_callback(void *context,
-    struct gdbwire_mi_stream_record *stream_record)
+/**
+ * Find the pending request a result record will belong to.
+ *
+ * @param tgdb
+ * The tgdb instance
+ *
+ * @param token
+ * The token of the result record or NULL if it has none.
+ *
+ * @return
+ * The request, which is left pending, or NULL if there is none.
+ */
+static tgdb_request_ptr tgdb_pending_request_find(struct tgdb *tgdb,
+        const char *token)
 {
-    struct tgdb *tgdb = (struct tgdb*)context;
+    tgdb_request_ptr_map::iterator iter;
 
-    switch (tgdb->current_request_type) {
-        case TGDB_REQUEST_BREAKPOINTS:
-        case TGDB_REQUEST_INFO_FRAME:
-            /**
-             * When using GDB with annotate=2 and also using interpreter-exec,
-             * GDB spits out the annotations in the MI output. All of these
-             * annotations can be ignored.
-             */
-            break;
-        case TGDB_REQUEST_DISASSEMBLE_PC:
-        case TGDB_REQUEST_DISASSEMBLE_FUNC:
-            if (stream_record->kind == GDBWIRE_MI_CONSOLE) {
-                uint64_t address;
-                int result;
-                char *str = stream_record->cstring;
-                size_t length = strlen(str);
-                char *colon = 0, colon_char = 0;
-
-                if (str[length-1] == '\n') {
-                    str[length-1] = 0;
-                }
+    if (token) {
+        iter = tgdb->pending_requests->find(strtoul(token, NULL, 10));
+    } else {
+        iter = tgdb->pending_requests->begin();
+    }
 
-                /* Trim the gdb current location pointer off */
-                if (length > 2 && str[0] == '=' && str[1] == '>') {
-                    str[0] = ' ';
-                    str[1] = ' ';
-                }
+    if (iter == tgdb->pending_requests->end()) {
+        return NULL;
+    }
 
-                sbpush(tgdb->disasm, cgdb_strdup(str));
+    return iter->second;
+}
 
-                colon = strchr((char*)str, ':');
-                if (colon) {
-                    colon_char = *colon;
-                    *colon = 0;
-                }
+/**
+ * Remove the request a result record belongs to from the pending table.
+ *
+ * @param tgdb
+ * The tgdb instance
+ *
+ * @param token
+ * The token of the result record or NULL if it has none. Without a token
+ * the result is assumed to belong to the oldest pending request.
+ *
+ * @return
+ * The request, which the caller now owns, or NULL if it is unknown.
+ */
+static tgdb_request_ptr tgdb_pending_request_take(struct tgdb *tgdb,
+        const char *token)
+{
+    tgdb_request_ptr_map::iterator iter;
+    tgdb_request_ptr request;
 
-                result = cgdb_hexstr_to_u64(str, &address);
+    if (token) {
+        iter = tgdb->pending_requests->find(strtoul(token, NULL, 10));
+    } else {
+        iter = tgdb->pending_requests->begin();
+    }
 
-                if (colon) {
-                    *colon = colon_char;
-                }
+    if (iter == tgdb->pending_requests->end()) {
+        clog_error(CLOG_CGDB, "result record for unknown token [%s]",
+                token ? token : "");
+        return NULL;
+    }
 
-                if (result == 0 && address) {
-                    tgdb->address_start = tgdb->address_start ?
-                         MIN(address, tgdb->address_start) : address;
-                    tgdb->address_end = MAX(address, tgdb->address_end);
-                }
-            }
-            break;
-        case TGDB_REQUEST_DATA_DISASSEMBLE_MODE_QUERY:
-        case TGDB_REQUEST_INFO_SOURCES:
-        case TGDB_REQUEST_INFO_SOURCE_FILE:
-        case TGDB_REQUEST_TTY:
-        case TGDB_REQUEST_DEBUGGER_COMMAND:
-        case TGDB_REQUEST_MODIFY_BREAKPOINT:
-            break;
+    request = iter->second;
+    tgdb->pending_requests->erase(iter);
+
+    return request;
+}
+
+static void gdbwire_stream_record_callback(void *context,
+    struct gdbwire_mi_stream_record *stream_record)
+{
+    struct tgdb *tgdb = (struct tgdb*)context;
+
+    /**
+     * Every request tgdb makes is answered by its result record, except
+     * for the CLI disassemble command. See tgdb_disassemble_cli_line.
+     *
+     * When using GDB with annotate=2 and also using interpreter-exec,
+     * GDB spits out the annotations in the MI output. All of these
+     * annotations can be ignored.
+     */
+    if (tgdb->cli_disassembling &&
+            stream_record->kind == GDBWIRE_MI_CONSOLE) {
+        tgdb_disassemble_cli_line(tgdb, stream_record->cstring);
     }
 }
 
+// The fields of the frame tuple of a stop
+enum tgdb_frame_field {
+    TGDB_FRAME_ADDR,
+    TGDB_FRAME_FULLNAME,
+    TGDB_FRAME_LINE,
+    TGDB_FRAME_FIELDS
+};
+
+static const char *const tgdb_frame_fields[] = {
+    "addr",
+    "fullname",
+    "line"
+};
+
+static struct gdbwire_mi_schema tgdb_frame_schema =
+    GDBWIRE_MI_SCHEMA(tgdb_frame_fields);
+
 static void
 source_position_changed(struct tgdb *tgdb, gdbwire_mi_result *result)
 {
-    std::string frame("frame");
-    std::string addr("addr");
-    std::string fullname("fullname");
-    std::string line("line");
-
     while (result) {
-        if (frame == result->variable &&
-            result->kind == GDBWIRE_MI_TUPLE) {
+        if (result->kind == GDBWIRE_MI_TUPLE &&
+            strcmp(result->variable, "frame") == 0) {
 
+            char *fields[TGDB_FRAME_FIELDS];
             uint64_t addr_value = 0;
-            bool addr_value_set = false;
+            const char *fullname_value;
+            int line_value = 0;
 
-            std::string fullname_value;
-            bool fullname_value_set = false;
+            gdbwire_mi_schema_extract(&tgdb_frame_schema,
+                    result->variant.result, fields);
 
-            int line_value = 0;
-            bool line_value_set = false;
-
-            struct gdbwire_mi_result *fresult = result->variant.result;
-
-            while (fresult) {
-                if (addr == fresult->variable) {
-                    addr_value = std::stoull(
-                            fresult->variant.cstring, 0, 16);
-                    addr_value_set = true;
-                } else if (fullname == fresult->variable) {
-                    fullname_value = fresult->variant.cstring;
-                    fullname_value_set = true;
-                } else if (line == fresult->variable) {
-                    line_value = std::stoi(fresult->variant.cstring);
-                    line_value_set = true;
-                }
-                fresult = fresult->next;
+            fullname_value = fields[TGDB_FRAME_FULLNAME];
+
+            if (fields[TGDB_FRAME_ADDR]) {
+                addr_value = std::stoull(fields[TGDB_FRAME_ADDR], 0, 16);
+            }
+
+            if (fields[TGDB_FRAME_LINE]) {
+                line_value = std::stoi(fields[TGDB_FRAME_LINE]);
             }
 
-            if(addr_value_set || (fullname_value_set && line_value_set)) {
-                tgdb_commands_send_source_file(tgdb, fullname_value.c_str(),
+            if (fields[TGDB_FRAME_ADDR] ||
+                    (fullname_value && fields[TGDB_FRAME_LINE])) {
+                tgdb_commands_send_source_file(tgdb,
+                        fullname_value ? fullname_value : "",
                         NULL, addr_value, NULL, NULL, line_value);
+
+                // The location just sent is newer than anything a queued
+                // location request made before this stop could report
+                tgdb_supersede_location_requests(tgdb);
             }
         }
 
@@ -499,7 +2224,6 @@ source_position_changed(struct tgdb *tgdb, gdbwire_mi_result *result)
     }
 }
 
-void tgdb_breakpoints_changed(void *context);
 static void gdbwire_async_record_callback(void *context,
         struct gdbwire_mi_async_record *async_record)
 {
@@ -513,28 +2237,149 @@ static void gdbwire_async_record_callback(void *context,
         case GDBWIRE_MI_ASYNC_BREAKPOINT_CREATED:
         case GDBWIRE_MI_ASYNC_BREAKPOINT_MODIFIED:
         case GDBWIRE_MI_ASYNC_BREAKPOINT_DELETED:
-            tgdb_breakpoints_changed(tgdb);
+            tgdb_commands_process_breakpoint_async_record(tgdb, async_record);
+            break;
+        case GDBWIRE_MI_ASYNC_THREAD_GROUP_STARTED:
+            // A new process can put different code at addresses
+            // that were already disassembled
+            tgdb_disasm_cache_clear(tgdb);
+            break;
+        case GDBWIRE_MI_ASYNC_LIBRARY_UNLOADED:
+            tgdb_disasm_cache_clear(tgdb);
+            tgdb_source_files_changed(tgdb);
+            break;
+        case GDBWIRE_MI_ASYNC_LIBRARY_LOADED:
+            tgdb_source_files_changed(tgdb);
             break;
         default:
             break;
     }
 }
 
+/**
+ * Tell gdbwire which records gdbwire_async_record_callback and
+ * gdbwire_stream_record_callback act on.
+ *
+ * Everything else GDB sends asynchronously, like the =library-loaded
+ * storm when a program starts, is skipped without being parsed.
+ */
+static void tgdb_set_wire_interests(struct gdbwire *wire)
+{
+    int async_class;
+
+    for (async_class = GDBWIRE_MI_ASYNC_DOWNLOAD;
+         async_class <= GDBWIRE_MI_ASYNC_UNSUPPORTED; ++async_class) {
+        gdbwire_set_async_interest(wire,
+            (enum gdbwire_mi_async_class)async_class,
+            GDBWIRE_MI_INTEREST_NONE);
+    }
+
+    // The results of these are read
+    gdbwire_set_async_interest(wire, GDBWIRE_MI_ASYNC_STOPPED,
+        GDBWIRE_MI_INTEREST_FULL);
+    gdbwire_set_async_interest(wire, GDBWIRE_MI_ASYNC_THREAD_SELECTED,
+        GDBWIRE_MI_INTEREST_FULL);
+    gdbwire_set_async_interest(wire, GDBWIRE_MI_ASYNC_BREAKPOINT_CREATED,
+        GDBWIRE_MI_INTEREST_FULL);
+    gdbwire_set_async_interest(wire, GDBWIRE_MI_ASYNC_BREAKPOINT_MODIFIED,
+        GDBWIRE_MI_INTEREST_FULL);
+    gdbwire_set_async_interest(wire, GDBWIRE_MI_ASYNC_BREAKPOINT_DELETED,
+        GDBWIRE_MI_INTEREST_FULL);
+
+    // Only the class of these matters
+    gdbwire_set_async_interest(wire, GDBWIRE_MI_ASYNC_THREAD_GROUP_STARTED,
+        GDBWIRE_MI_INTEREST_CLASS);
+    gdbwire_set_async_interest(wire, GDBWIRE_MI_ASYNC_LIBRARY_LOADED,
+        GDBWIRE_MI_INTEREST_CLASS);
+    gdbwire_set_async_interest(wire, GDBWIRE_MI_ASYNC_LIBRARY_UNLOADED,
+        GDBWIRE_MI_INTEREST_CLASS);
+
+    // Stream records on the MI channel are ignored, unless functions are
+    // disassembled with the CLI, see
+    // tgdb_commands_process_disassemble_func_query
+    gdbwire_set_stream_interest(wire, GDBWIRE_MI_CONSOLE,
+        GDBWIRE_MI_INTEREST_NONE);
+    gdbwire_set_stream_interest(wire, GDBWIRE_MI_TARGET,
+        GDBWIRE_MI_INTEREST_NONE);
+    gdbwire_set_stream_interest(wire, GDBWIRE_MI_LOG,
+        GDBWIRE_MI_INTEREST_NONE);
+}
+
+static void gdbwire_source_file_callback(void *context, const char *token,
+        struct gdbwire_mi_result *file)
+{
+    struct tgdb *tgdb = (struct tgdb*)context;
+    tgdb_request_ptr request = tgdb_pending_request_find(tgdb, token);
+
+    if (request && request->header == TGDB_REQUEST_INFO_SOURCES) {
+        tgdb_source_files_add(tgdb, request, file);
+    }
+}
+
+static void gdbwire_breakpoint_row_callback(void *context, const char *token,
+        struct gdbwire_mi_result *row)
+{
+    struct tgdb *tgdb = (struct tgdb*)context;
+    tgdb_request_ptr request = tgdb_pending_request_find(tgdb, token);
+
+    if (request && request->header == TGDB_REQUEST_BREAKPOINTS) {
+        tgdb_breakpoints_add_row(tgdb, request, row);
+    }
+}
+
+/**
+ * Find out if -data-disassemble supports -a from the answer to
+ * TGDB_REQUEST_DATA_DISASSEMBLE_FUNC_QUERY.
+ *
+ * If it does not, the console stream records are needed to read the
+ * output of the CLI disassemble command used instead.
+ */
+static void tgdb_commands_process_disassemble_func_query(struct tgdb *tgdb,
+        struct gdbwire_mi_result_record *result_record)
+{
+    struct gdbwire_mi_result *result = result_record->result;
+
+    for (; result; result = result->next) {
+        if (result->kind == GDBWIRE_MI_CSTRING &&
+                strcmp(result->variable, "msg") == 0 &&
+                strstr(result->variant.cstring, "Unknown option")) {
+            gdbwire_set_stream_interest(tgdb->wire, GDBWIRE_MI_CONSOLE,
+                GDBWIRE_MI_INTEREST_FULL);
+            return;
+        }
+    }
+
+    tgdb->disassemble_supports_a_option = 1;
+    clog_info(CLOG_CGDB, "disassemble supports a option");
+}
+
 static void gdbwire_result_record_callback(void *context,
         struct gdbwire_mi_result_record *result_record)
 {
     struct tgdb *tgdb = (struct tgdb*)context;
+    tgdb_request_ptr request =
+        tgdb_pending_request_take(tgdb, result_record->token);
+
+    if (!request) {
+        return;
+    }
 
-    switch (tgdb->current_request_type) {
+    request->result_time = tgdb_time_usec();
+    if (!request->first_byte_time) {
+        request->first_byte_time = tgdb->mi_read_time;
+    }
+
+    switch (request->header) {
         case TGDB_REQUEST_BREAKPOINTS:
-            tgdb_commands_process_breakpoints(tgdb, result_record);
+            tgdb_commands_process_breakpoints(tgdb, request, result_record);
             break;
         case TGDB_REQUEST_INFO_SOURCES:
-            tgdb_commands_process_info_sources(tgdb, result_record);
+            tgdb_commands_process_info_sources(tgdb, request, result_record);
             break;
         case TGDB_REQUEST_DISASSEMBLE_PC:
         case TGDB_REQUEST_DISASSEMBLE_FUNC:
-            send_disassemble_func_complete_response(tgdb, result_record);
+            send_disassemble_func_complete_response(tgdb, request,
+                    result_record);
             break;
         case TGDB_REQUEST_DATA_DISASSEMBLE_MODE_QUERY:
             /**
@@ -547,6 +2392,10 @@ static void gdbwire_result_record_callback(void *context,
                 clog_info(CLOG_CGDB, "disassemble supports s mode");
             }
             break;
+        case TGDB_REQUEST_DATA_DISASSEMBLE_FUNC_QUERY:
+            tgdb_commands_process_disassemble_func_query(tgdb,
+                    result_record);
+            break;
         case TGDB_REQUEST_INFO_SOURCE_FILE:
             tgdb_commands_process_info_source(tgdb, result_record);
             break;
@@ -558,6 +2407,14 @@ static void gdbwire_result_record_callback(void *context,
         case TGDB_REQUEST_MODIFY_BREAKPOINT:
             break;
     }
+
+    request->done_time = tgdb_time_usec();
+    tgdb_latency_record(tgdb, request);
+
+    tgdb_request_destroy(tgdb, request);
+
+    // A slot in the pipeline opened up, fill it
+    tgdb_unqueue_and_deliver_commands(tgdb);
 }
 
 void tgdb_console_at_prompt(void *context);
@@ -599,17 +2456,6 @@ int free_char_star(void *item)
     return 0;
 }
 
-void tgdb_commands_process(struct tgdb *tgdb, const std::string &str)
-{
-   gdbwire_push_data(tgdb->wire, str.data(), str.size());
-}
-
-void tgdb_commands_set_current_request_type(struct tgdb *tgdb,
-        enum tgdb_request_type type)
-{
-    tgdb->current_request_type = type;
-}
-
 int tgdb_commands_disassemble_supports_s_mode(struct tgdb *tgdb)
 {
     return tgdb->disassemble_supports_s_mode;
@@ -631,21 +2477,60 @@ static struct tgdb *initialize_tgdb_context(tgdb_callbacks callbacks)
     tgdb->new_ui_pty_pair = NULL;
 
     tgdb->command_requests = new tgdb_request_ptr_list();
+    tgdb->pending_requests = new tgdb_request_ptr_map();
+    tgdb->next_token = 1;
 
-    tgdb->is_gdb_ready_for_next_command = 0;
+    tgdb->is_mi_channel_ready = 0;
 
     tgdb->callbacks = callbacks;
 
-    tgdb->disasm = NULL;
-    tgdb->address_start = 0;
-    tgdb->address_end = 0;
+    tgdb->mi_read_time = 0;
+    tgdb->latency_stats = new tgdb_latency_stats();
+
+    tgdb->session_file = NULL;
+    tgdb->session_start_time = 0;
+
+    tgdb->disasm_cache = new tgdb_disasm_cache();
+    tgdb->disasm_sources = new tgdb_disasm_sources();
 
     wire_callbacks.context = (void*)tgdb;
     tgdb->wire = gdbwire_create(wire_callbacks);
+    tgdb_set_wire_interests(tgdb->wire);
+
+    // The largest lists gdb answers with are converted as they are parsed.
+    // They are still only sent to the front end with the result record:
+    // the source file list and breakpoint list each replace what the front
+    // end showed, and an error result must not leave half a list behind.
+    gdbwire_stream_list(tgdb->wire, "files",
+            gdbwire_source_file_callback, tgdb);
+    gdbwire_stream_list(tgdb->wire, "BreakpointTable.body",
+            gdbwire_breakpoint_row_callback, tgdb);
+
+    tgdb->breakpoints = new tgdb_breakpoint_map();
+
+    tgdb->source_files = NULL;
+    tgdb->source_files_valid = false;
+    tgdb->source_files_stale = false;
+    tgdb->source_files_wanted = false;
 
     tgdb->disassemble_supports_s_mode = 0;
+    tgdb->disassemble_supports_a_option = 0;
+    tgdb->cli_disassembling = false;
+    tgdb->cli_disasm = NULL;
+    tgdb->cli_disasm_start = 0;
+    tgdb->cli_disasm_end = 0;
     tgdb->gdb_supports_new_ui_command = true;
-    tgdb->undefined_new_ui_command = new std::string();
+    tgdb->console_partial_line = new std::string();
+
+    tgdb->read_buffer_size = TGDB_READ_BUFFER_MIN;
+    tgdb->read_buffer = (char *)cgdb_malloc(tgdb->read_buffer_size);
+
+    tgdb->console_writes = new tgdb_write_queue();
+    tgdb->mi_writes = new tgdb_write_queue();
+
+    tgdb->interned_strings = new tgdb_string_set();
+    tgdb->request_pool = NULL;
+    tgdb->response_pool = NULL;
 
     return tgdb;
 }
@@ -655,18 +2540,26 @@ static struct tgdb *initialize_tgdb_context(tgdb_callbacks callbacks)
  ******************************************************************************/
 
 static void tgdb_issue_request(struct tgdb *tgdb, enum tgdb_request_type type,
-        bool priority)
+        enum tgdb_request_priority priority)
 {
-    tgdb_request_ptr request_ptr;
-    request_ptr = (tgdb_request_ptr)cgdb_malloc(sizeof (struct tgdb_request));
-    request_ptr->header = type;
+    tgdb_request_ptr request_ptr = tgdb_request_create(tgdb, type);
     tgdb_run_or_queue_request(tgdb, request_ptr, priority);
 }
  
 void tgdb_breakpoints_changed(void *context)
 {
     struct tgdb *tgdb = (struct tgdb*)context;
-    tgdb_issue_request(tgdb, TGDB_REQUEST_BREAKPOINTS, true);
+    tgdb_issue_request(tgdb, TGDB_REQUEST_BREAKPOINTS, TGDB_PRIORITY_STATE);
+}
+
+// GDB loaded or unloaded symbols, so the cached source file list may be
+// out of date. Fetch it again once gdb has nothing else to do.
+static void tgdb_source_files_changed(struct tgdb *tgdb)
+{
+    tgdb->source_files_valid = false;
+    tgdb->source_files_stale = true;
+    tgdb_issue_request(tgdb, TGDB_REQUEST_INFO_SOURCES,
+            TGDB_PRIORITY_BACKGROUND);
 }
 
 static void tgdb_source_location_changed(void *context)
@@ -680,18 +2573,40 @@ static void tgdb_command_error(void *context, const std::string &msg)
     struct tgdb *tgdb = (struct tgdb*)context;
 
     /* Send cgdb the error message */
-    tgdb->callbacks.console_output_callback(tgdb->callbacks.context, msg);
+    tgdb->callbacks.console_output_callback(tgdb->callbacks.context,
+            msg.data(), msg.size());
 }
 
 void tgdb_console_at_prompt(void *context)
 {
     struct tgdb *tgdb = (struct tgdb*)context;
 
-    tgdb->is_gdb_ready_for_next_command = 1;
+    tgdb->is_mi_channel_ready = 1;
+
+    tgdb_unqueue_and_deliver_commands(tgdb);
+}
+
+/**
+ * Create a request, reusing a destroyed one if there is one.
+ *
+ * @param header
+ * The type of request. Everything else in the request is zeroed.
+ */
+static tgdb_request_ptr tgdb_request_create(struct tgdb *tgdb,
+        enum tgdb_request_type header)
+{
+    tgdb_request_ptr request_ptr;
 
-    if (tgdb->command_requests->size() > 0) {
-        tgdb_unqueue_and_deliver_command(tgdb);
+    if (sbcount(tgdb->request_pool) > 0) {
+        request_ptr = sbpop(tgdb->request_pool);
+        memset(request_ptr, 0, sizeof (struct tgdb_request));
+    } else {
+        request_ptr = (tgdb_request_ptr)cgdb_calloc(1,
+                sizeof (struct tgdb_request));
     }
+
+    request_ptr->header = header;
+    return request_ptr;
 }
 
 /**
@@ -700,18 +2615,28 @@ void tgdb_console_at_prompt(void *context)
  * @param request_ptr
  * The request pointer to destroy.
  */
-static void tgdb_request_destroy(tgdb_request_ptr request_ptr)
+static void tgdb_request_destroy(struct tgdb *tgdb,
+        tgdb_request_ptr request_ptr)
 {
     if (!request_ptr)
         return;
 
     switch (request_ptr->header) {
         case TGDB_REQUEST_INFO_SOURCES:
+            tgdb_source_files_free(
+                    request_ptr->choice.info_sources.source_files);
+            break;
+        case TGDB_REQUEST_BREAKPOINTS:
+            tgdb_breakpoints_free(request_ptr->choice.breakpoints.breakpoints);
+            if (request_ptr->choice.breakpoints.table) {
+                tgdb_breakpoint_map_clear(request_ptr->choice.breakpoints.table);
+                delete request_ptr->choice.breakpoints.table;
+            }
             break;
         case TGDB_REQUEST_DEBUGGER_COMMAND:
             break;
         case TGDB_REQUEST_MODIFY_BREAKPOINT:
-            free((char *) request_ptr->choice.modify_breakpoint.file);
+            // The file is interned
             request_ptr->choice.modify_breakpoint.file = NULL;
             break;
         case TGDB_REQUEST_DISASSEMBLE_PC:
@@ -721,8 +2646,11 @@ static void tgdb_request_destroy(tgdb_request_ptr request_ptr)
             break;
     }
 
-    free(request_ptr);
-    request_ptr = NULL;
+    if (sbcount(tgdb->request_pool) < TGDB_POOL_MAX) {
+        sbpush(tgdb->request_pool, request_ptr);
+    } else {
+        free(request_ptr);
+    }
 }
 
 
@@ -744,6 +2672,9 @@ struct tgdb *tgdb_initialize(tgdb_callbacks callbacks)
     tgdb->gdb_mi_ui_fd = pty_pair_get_masterfd(tgdb->new_ui_pty_pair);
     tty_set_echo(tgdb->gdb_mi_ui_fd, 0);
 
+    // tgdb_process reads everything available, without blocking
+    io_set_nonblocking(tgdb->gdb_mi_ui_fd);
+
     /* Need to get source information before breakpoint information otherwise
      * the TGDB_UPDATE_BREAKPOINTS event will be ignored in process_commands()
      * because there are no source files to add the breakpoints to.
@@ -754,12 +2685,19 @@ struct tgdb *tgdb_initialize(tgdb_callbacks callbacks)
      * if the user puts breakpoints in there .gdbinit.
      * This makes sure that TGDB asks for the breakpoints on start up.
      */
-    tgdb_issue_request(tgdb, TGDB_REQUEST_BREAKPOINTS, true);
+    tgdb_issue_request(tgdb, TGDB_REQUEST_BREAKPOINTS, TGDB_PRIORITY_STATE);
 
     /**
      * Query if disassemble supports the /s flag
      */
-    tgdb_issue_request(tgdb, TGDB_REQUEST_DATA_DISASSEMBLE_MODE_QUERY, true);
+    tgdb_issue_request(tgdb, TGDB_REQUEST_DATA_DISASSEMBLE_MODE_QUERY,
+            TGDB_PRIORITY_STATE);
+
+    /**
+     * Query if -data-disassemble supports the -a option
+     */
+    tgdb_issue_request(tgdb, TGDB_REQUEST_DATA_DISASSEMBLE_FUNC_QUERY,
+            TGDB_PRIORITY_STATE);
 
     return tgdb;
 }
@@ -778,24 +2716,50 @@ int tgdb_start_gdb(struct tgdb *tgdb,
     if (tgdb->debugger_pid == -1)
         return -1;
 
+    io_set_nonblocking(tgdb->debugger_stdout);
+
     *gdb_console_fd = tgdb->debugger_stdout;
     *gdb_mi_fd = tgdb->gdb_mi_ui_fd;
 
     return 0;
 }
 
+int tgdb_connect_gdb(struct tgdb *tgdb, int console_fd, int mi_fd)
+{
+    tgdb->debugger_pid = -1;
+    tgdb->debugger_stdin = console_fd;
+    tgdb->debugger_stdout = console_fd;
+    tgdb->gdb_mi_ui_fd = mi_fd;
+
+    io_set_nonblocking(console_fd);
+    io_set_nonblocking(mi_fd);
+
+    return 0;
+}
+
 int tgdb_shutdown(struct tgdb *tgdb)
 {
-    delete tgdb->undefined_new_ui_command;
+    delete tgdb->console_partial_line;
+    free(tgdb->read_buffer);
+    tgdb->read_buffer = NULL;
 
     tgdb_request_ptr_list::iterator iter = tgdb->command_requests->begin();
     for (; iter != tgdb->command_requests->end(); ++iter) {
-        tgdb_request_destroy(*iter);
+        tgdb_request_destroy(tgdb, *iter);
     }
 
     delete tgdb->command_requests;
     tgdb->command_requests = 0;
 
+    tgdb_request_ptr_map::iterator pending_iter =
+        tgdb->pending_requests->begin();
+    for (; pending_iter != tgdb->pending_requests->end(); ++pending_iter) {
+        tgdb_request_destroy(tgdb, pending_iter->second);
+    }
+
+    delete tgdb->pending_requests;
+    tgdb->pending_requests = 0;
+
     if (tgdb->debugger_stdin != -1) {
         cgdb_close(tgdb->debugger_stdin);
         tgdb->debugger_stdin = -1;
@@ -803,6 +2767,58 @@ int tgdb_shutdown(struct tgdb *tgdb)
 
     gdbwire_destroy(tgdb->wire);
 
+    tgdb_breakpoint_table_clear(tgdb);
+    delete tgdb->breakpoints;
+    tgdb->breakpoints = 0;
+
+    delete tgdb->disasm_cache;
+    tgdb->disasm_cache = 0;
+    delete tgdb->disasm_sources;
+    tgdb->disasm_sources = 0;
+
+    // Drop the lines of a CLI disassemble command that never finished
+    tgdb_send_disassemble_cli(tgdb, false);
+
+    tgdb_source_files_free(tgdb->source_files);
+    tgdb->source_files = NULL;
+
+    while (sbcount(tgdb->request_pool) > 0) {
+        free(sbpop(tgdb->request_pool));
+    }
+    sbfree(tgdb->request_pool);
+    tgdb->request_pool = NULL;
+
+    while (sbcount(tgdb->response_pool) > 0) {
+        free(sbpop(tgdb->response_pool));
+    }
+    sbfree(tgdb->response_pool);
+    tgdb->response_pool = NULL;
+
+    // Nothing refers to the interned strings any more
+    tgdb_string_set::iterator string_iter = tgdb->interned_strings->begin();
+    for (; string_iter != tgdb->interned_strings->end(); ++string_iter) {
+        free((char *)*string_iter);
+    }
+    delete tgdb->interned_strings;
+    tgdb->interned_strings = 0;
+
+    if (clog_enabled(CLOG_CGDB_ID, CLOG_DEBUG)) {
+        clog_debug(CLOG_CGDB, "tgdb request latencies\n%s",
+                tgdb_get_request_stats(tgdb).c_str());
+    }
+    delete tgdb->latency_stats;
+    tgdb->latency_stats = 0;
+
+    delete tgdb->console_writes;
+    tgdb->console_writes = 0;
+    delete tgdb->mi_writes;
+    tgdb->mi_writes = 0;
+
+    if (tgdb->session_file) {
+        fclose(tgdb->session_file);
+        tgdb->session_file = NULL;
+    }
+
     return 0;
 }
 
@@ -883,7 +2899,182 @@ static char *tgdb_client_modify_breakpoint_call(struct tgdb *tgdb,
  ******************************************************************************/
 
 /**
- * Run a command request if gdb is idle, otherwise queue it.
+ * Determine if running a request twice in a row gives the same answer
+ * as running it once.
+ *
+ * Only these requests may be merged with one another by the scheduler.
+ *
+ * @param request
+ * The request to check
+ *
+ * @return
+ * True if the request only queries gdb, false otherwise.
+ */
+static bool tgdb_request_is_idempotent(tgdb_request_ptr request)
+{
+    switch (request->header) {
+        case TGDB_REQUEST_INFO_SOURCES:
+        case TGDB_REQUEST_INFO_SOURCE_FILE:
+        case TGDB_REQUEST_BREAKPOINTS:
+        case TGDB_REQUEST_INFO_FRAME:
+        case TGDB_REQUEST_DATA_DISASSEMBLE_MODE_QUERY:
+        case TGDB_REQUEST_DATA_DISASSEMBLE_FUNC_QUERY:
+        case TGDB_REQUEST_DISASSEMBLE_PC:
+        case TGDB_REQUEST_DISASSEMBLE_FUNC:
+            return true;
+        case TGDB_REQUEST_TTY:
+        case TGDB_REQUEST_DEBUGGER_COMMAND:
+        case TGDB_REQUEST_MODIFY_BREAKPOINT:
+            break;
+    }
+
+    return false;
+}
+
+/**
+ * Determine if two idempotent requests would send the same command to gdb.
+ */
+static bool tgdb_request_equal(tgdb_request_ptr lhs, tgdb_request_ptr rhs)
+{
+    if (lhs->header != rhs->header) {
+        return false;
+    }
+
+    switch (lhs->header) {
+        case TGDB_REQUEST_DISASSEMBLE_PC:
+            return lhs->choice.disassemble.addr ==
+                    rhs->choice.disassemble.addr &&
+                lhs->choice.disassemble.lines ==
+                    rhs->choice.disassemble.lines;
+        case TGDB_REQUEST_DISASSEMBLE_FUNC:
+            return lhs->choice.disassemble_func.addr ==
+                    rhs->choice.disassemble_func.addr &&
+                lhs->choice.disassemble_func.source ==
+                    rhs->choice.disassemble_func.source &&
+                lhs->choice.disassemble_func.raw ==
+                    rhs->choice.disassemble_func.raw;
+        default:
+            break;
+    }
+
+    return true;
+}
+
+/**
+ * Determine if an identical request has been written to gdb and is still
+ * waiting for its result.
+ *
+ * The answer to the in flight request may predate the event that caused
+ * REQUEST to be made, so REQUEST can not be satisfied by it. However,
+ * there is no point in sending REQUEST until the in flight one returns
+ * since any duplicates made in the meantime can be merged into it.
+ */
+static bool tgdb_request_in_flight(struct tgdb *tgdb,
+        tgdb_request_ptr request)
+{
+    tgdb_request_ptr_map::iterator iter = tgdb->pending_requests->begin();
+    for (; iter != tgdb->pending_requests->end(); ++iter) {
+        if (tgdb_request_equal(iter->second, request)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Determine if a request is answered by the CLI disassemble command,
+ * rather than by an MI command.
+ */
+static bool tgdb_request_uses_cli(struct tgdb *tgdb, tgdb_request_ptr request)
+{
+    return request->header == TGDB_REQUEST_DISASSEMBLE_FUNC &&
+        !tgdb->disassemble_supports_a_option;
+}
+
+/**
+ * Put a request on the queue.
+ *
+ * The request is placed after all queued requests of the same or a more
+ * urgent priority class. If an identical idempotent request is already
+ * queued, only the one that runs later is kept. That way no caller gets
+ * an answer that is older than it asked for. A queued duplicate of a less
+ * urgent class is replaced, which promotes it.
+ *
+ * @param tgdb
+ * The TGDB context to use.
+ *
+ * @param request
+ * The command request to queue
+ */
+static void tgdb_queue_request(struct tgdb *tgdb, tgdb_request_ptr request)
+{
+    tgdb_request_ptr_list *queue = tgdb->command_requests;
+    tgdb_request_ptr_list::iterator pos = queue->begin();
+    tgdb_request_ptr_list::iterator iter;
+
+    while (pos != queue->end() && (*pos)->priority <= request->priority) {
+        ++pos;
+    }
+
+    if (tgdb_request_is_idempotent(request)) {
+        for (iter = queue->begin(); iter != queue->end(); ++iter) {
+            if (tgdb_request_equal(*iter, request)) {
+                break;
+            }
+        }
+
+        if (iter != queue->end()) {
+            // Is the queued duplicate going to run after REQUEST would?
+            tgdb_request_ptr_list::iterator later = pos;
+            while (later != queue->end() && later != iter) {
+                ++later;
+            }
+
+            if (later == iter && (*iter)->priority == request->priority) {
+                tgdb_request_destroy(tgdb, request);
+                return;
+            }
+
+            // The duplicate may be where REQUEST goes, keep POS valid
+            tgdb_request_destroy(tgdb, *iter);
+            if (iter == pos) {
+                pos = queue->erase(iter);
+            } else {
+                queue->erase(iter);
+            }
+        }
+    }
+
+    queue->insert(pos, request);
+}
+
+/**
+ * Drop queued requests for the current location.
+ *
+ * Called when gdb reports a new location on its own, after a stop.
+ * Any location request queued before that is answered by it.
+ *
+ * @param tgdb
+ * The TGDB context to use.
+ */
+static void tgdb_supersede_location_requests(struct tgdb *tgdb)
+{
+    tgdb_request_ptr_list::iterator iter = tgdb->command_requests->begin();
+    while (iter != tgdb->command_requests->end()) {
+        if ((*iter)->header == TGDB_REQUEST_INFO_FRAME ||
+            (*iter)->header == TGDB_REQUEST_INFO_SOURCE_FILE) {
+            tgdb_request_destroy(tgdb, *iter);
+            iter = tgdb->command_requests->erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+/**
+ * Run a command request if there is room in the mi pipeline, otherwise
+ * queue it.
  *
  * @param tgdb
  * The TGDB context to use.
@@ -892,32 +3083,30 @@ static char *tgdb_client_modify_breakpoint_call(struct tgdb *tgdb,
  * The command request
  *
  * @param priority
- * True if this is a priority request, false otherwise.
+ * The scheduling class of the request.
  */
 void tgdb_run_or_queue_request(struct tgdb *tgdb,
-        struct tgdb_request *request, bool priority)
+        struct tgdb_request *request, enum tgdb_request_priority priority)
 {
-    int can_issue;
-    
+    request->priority = priority;
+
+    request->enqueue_time = tgdb_time_usec();
+    request->send_time = 0;
+    request->first_byte_time = 0;
+    request->result_time = 0;
+    request->done_time = 0;
+
     // Debugger commands currently get executed in the gdb console
     // rather than the gdb mi channel. The gdb console is no longer
     // queued by CGDB, rather CGDB passes everything along to it that the
     // user types. So always issue debugger commands for now.
     if (request->header == TGDB_REQUEST_DEBUGGER_COMMAND) {
-        can_issue = 1;
-    } else {
-        can_issue = tgdb->is_gdb_ready_for_next_command;
-    }
-
-    if (can_issue) {
         tgdb_run_request(tgdb, request);
-    } else {
-        if (priority) {
-            tgdb->command_requests->push_front(request);
-        } else {
-            tgdb->command_requests->push_back(request);
-        }
+        return;
     }
+
+    tgdb_queue_request(tgdb, request);
+    tgdb_unqueue_and_deliver_commands(tgdb);
 }
 
 int tgdb_get_gdb_command(struct tgdb *tgdb, tgdb_request_ptr request,
@@ -926,6 +3115,11 @@ int tgdb_get_gdb_command(struct tgdb *tgdb, tgdb_request_ptr request,
 /**
  * Send a command to gdb.
  *
+ * Commands for the mi channel are prefixed with a unique token and kept
+ * in the pending table until gdb answers with a result record carrying
+ * the same token. The caller does not have to wait for that answer
+ * before sending the next command.
+ *
  * @param tgdb
  * An instance of tgdb
  *
@@ -936,8 +3130,6 @@ static void tgdb_run_request(struct tgdb *tgdb, struct tgdb_request *request)
 {
     std::string command;
 
-    tgdb->is_gdb_ready_for_next_command = 0;
-
     tgdb_get_gdb_command(tgdb, request, command);
 
     /* Add a newline to the end of the command if it doesn't exist */
@@ -945,48 +3137,93 @@ static void tgdb_run_request(struct tgdb *tgdb, struct tgdb_request *request)
         command.push_back('\n');
     }
 
-    /* Send what we're doing to log file */
-    std::string str = sys_quote_nonprintables(command.c_str(), -1);
-    clog_debug(CLOG_GDBMIIO, "%s", str.c_str());
+    // The answer to this request will include any symbol changes so far
+    if (request->header == TGDB_REQUEST_INFO_SOURCES) {
+        tgdb->source_files_stale = false;
+    }
+
+    request->send_time = tgdb_time_usec();
+
+    if (request->header != TGDB_REQUEST_DEBUGGER_COMMAND) {
+        unsigned long token = tgdb->next_token++;
+        command = std::to_string(token) + command;
+        (*tgdb->pending_requests)[token] = request;
+    }
 
-    /* A command for the debugger */
-    tgdb_commands_set_current_request_type(tgdb, request->header);
+    /* Send what we're doing to log file */
+    if (clog_enabled(CLOG_GDBMIIO_ID, CLOG_DEBUG)) {
+        std::string str = sys_quote_nonprintables(command.c_str(), -1);
+        clog_debug(CLOG_GDBMIIO, "%s", str.c_str());
+    }
 
     if (request->header == TGDB_REQUEST_DEBUGGER_COMMAND) {
         // since debugger commands are sent to the debugger's stdin
         // and not to the new-ui mi window, then we don't have to wait
-        // for gdb to respond with an mi prompt. CGDB can send as many
+        // for gdb to respond with an mi result. CGDB can send as many
         // commands as it likes, just as if the user typed it at the console
-        tgdb->is_gdb_ready_for_next_command = 1;
-        io_writen(tgdb->debugger_stdin, command.c_str(), command.size());
+        tgdb_session_record(tgdb, 'C', command.data(), command.size());
+        tgdb_write(tgdb, tgdb->debugger_stdin, command.data(), command.size());
+        tgdb_request_destroy(tgdb, request);
     } else {
-        io_writen(tgdb->gdb_mi_ui_fd, command.c_str(), command.size());
+        tgdb_session_record(tgdb, 'M', command.data(), command.size());
+        tgdb_write(tgdb, tgdb->gdb_mi_ui_fd, command.data(), command.size());
     }
-
-    tgdb_request_destroy(request);
 }
 
 /**
- * TGDB will search it's command queue's and determine what the next command
- * to deliever to GDB should be.
+ * TGDB will take commands off of its queue and deliver them to GDB until
+ * the queue is empty or the mi pipeline is full.
  *
- * \return
- * 0 on success, -1 on error
+ * Delivery also pauses while the next request duplicates one that is
+ * still in flight. That request then stays queued where later duplicates
+ * can be merged into it.
+ *
+ * Background requests are only delivered when nothing is in flight.
+ * A CLI disassemble command runs alone, see tgdb_disassemble_cli_line.
  */
-static void tgdb_unqueue_and_deliver_command(struct tgdb *tgdb)
+static void tgdb_unqueue_and_deliver_commands(struct tgdb *tgdb)
 {
-    if (tgdb->command_requests->size() > 0) {
+    if (!tgdb->is_mi_channel_ready) {
+        return;
+    }
+
+    while (tgdb->command_requests->size() > 0 &&
+            tgdb->pending_requests->size() < TGDB_MAX_PENDING_REQUESTS &&
+            !tgdb->cli_disassembling) {
         struct tgdb_request *request = tgdb->command_requests->front();
+
+        if (tgdb_request_is_idempotent(request) &&
+                tgdb_request_in_flight(tgdb, request)) {
+            break;
+        }
+
+        // Background requests must not delay anything the user is
+        // waiting for, so they wait until gdb is idle
+        if (request->priority == TGDB_PRIORITY_BACKGROUND &&
+                tgdb->pending_requests->size() > 0) {
+            break;
+        }
+
+        // The output of the CLI disassemble command is only known to be
+        // its own when nothing else runs, see tgdb_disassemble_cli_line
+        if (tgdb_request_uses_cli(tgdb, request) &&
+                tgdb->pending_requests->size() > 0) {
+            break;
+        }
+
         tgdb->command_requests->pop_front();
+        tgdb->cli_disassembling = tgdb_request_uses_cli(tgdb, request);
         tgdb_run_request(tgdb, request);
-        // TODO: free request?
     }
 }
 
 int tgdb_send_char(struct tgdb *tgdb, char c)
 {
-    if (io_write_byte(tgdb->debugger_stdin, c) == -1) {
-        clog_error(CLOG_CGDB, "io_write_byte failed");
+    tgdb_session_record_request(tgdb, "send_char 0x%02x", (unsigned char)c);
+    tgdb_session_record(tgdb, 'C', &c, 1);
+
+    if (tgdb_write(tgdb, tgdb->debugger_stdin, &c, 1) == -1) {
+        clog_error(CLOG_CGDB, "tgdb_write failed");
         return -1;
     }
 
@@ -1005,7 +3242,7 @@ int tgdb_send_char(struct tgdb *tgdb, char c)
 static int tgdb_add_quit_command(struct tgdb *tgdb, bool new_ui_unsupported)
 {
     struct tgdb_response *response;
-    response = tgdb_create_response(TGDB_QUIT);
+    response = tgdb_create_response(tgdb, TGDB_QUIT);
     response->choice.quit.new_ui_unsupported = new_ui_unsupported;
     tgdb_send_response(tgdb, response);
     return 0;
@@ -1049,7 +3286,7 @@ static void tgdb_handle_control_c(struct tgdb *tgdb)
     if (tgdb->control_c) {
         tgdb_request_ptr_list::iterator iter = tgdb->command_requests->begin();
         for (; iter != tgdb->command_requests->end(); ++iter) {
-            tgdb_request_destroy(*iter);
+            tgdb_request_destroy(tgdb, *iter);
         }
         tgdb->command_requests->clear();
 
@@ -1057,47 +3294,157 @@ static void tgdb_handle_control_c(struct tgdb *tgdb)
     }
 }
 
-// Search for the string
+/**
+ * Determine if a line of console output starts with a string.
+ */
+static bool tgdb_line_starts_with(const char *line, size_t size,
+        const char *prefix)
+{
+    size_t length = strlen(prefix);
+    return size >= length && memcmp(line, prefix, length) == 0;
+}
+
+// Check a complete line of console output for the strings tgdb cares
+// about. See tgdb_search_console_output.
+static void tgdb_search_console_line(struct tgdb *tgdb, const char *line,
+        size_t size, bool &symbols_read)
+{
+    static const char *new_ui_text = "Undefined command: \"new-ui\".";
+    static const char *reading_symbols_text = "Reading symbols from ";
+
+    if (tgdb_line_starts_with(line, size, new_ui_text)) {
+        tgdb->gdb_supports_new_ui_command = false;
+    } else if (tgdb_line_starts_with(line, size, reading_symbols_text)) {
+        symbols_read = true;
+    }
+}
+
+// Search the console output for the lines tgdb cares about.
+//
+// The string
 //   Undefined command: "new-ui"
-// to determine if this gdb supports the new-ui command or not.
+// determines if this gdb supports the new-ui command or not.
 // If the string is found, set tgdb->gdb_supports_new_ui_command to false
-static void tgdb_search_for_unsupported_new_ui_message(
-        struct tgdb *tgdb, const std::string &console_output)
+//
+// The string
+//   Reading symbols from
+// is printed when gdb loads a program, at startup or with the file
+// command. The source file list is fetched again when it is found.
+//
+// Only the start of each line matters, so the output is searched where
+// it is. Just the start of a line that is not complete yet is kept.
+static void tgdb_search_console_output(
+        struct tgdb *tgdb, const char *data, size_t size)
 {
-    static const char *new_ui_text = "Undefined command: \"new-ui\".";
-    
-    (*tgdb->undefined_new_ui_command) += console_output;
+    std::string &partial = *tgdb->console_partial_line;
+    const char *end = data + size;
+    bool symbols_read = false;
+
+    while (data < end) {
+        const char *newline = (const char *)memchr(data, '\n', end - data);
+        const char *line_end = newline ? newline : end;
+
+        if (newline && partial.empty()) {
+            // The whole line is in this output
+            tgdb_search_console_line(tgdb, data, newline - data,
+                    symbols_read);
+        } else {
+            if (partial.size() < TGDB_CONSOLE_LINE_PREFIX) {
+                partial.append(data, std::min((size_t)(line_end - data),
+                        (size_t)(TGDB_CONSOLE_LINE_PREFIX - partial.size())));
+            }
+
+            if (newline) {
+                tgdb_search_console_line(tgdb, partial.data(),
+                        partial.size(), symbols_read);
+                partial.clear();
+            }
+        }
 
-    std::istringstream ss(*tgdb->undefined_new_ui_command);
-    std::string line;
-    while (getline(ss, line)) {
-        if (line.find(new_ui_text) == 0) {
-            tgdb->gdb_supports_new_ui_command = false;
+        if (!newline) {
             break;
         }
+
+        data = newline + 1;
+    }
+
+    if (symbols_read) {
+        tgdb_source_files_changed(tgdb);
     }
+}
+
+/**
+ * Read everything gdb has written to a file descriptor so far.
+ *
+ * The descriptor is non-blocking, so it is read until it would block.
+ * The read buffer doubles in size whenever a read fills it, up to
+ * TGDB_READ_BUFFER_MAX bytes. Anything left over is read the next time.
+ *
+ * @param tgdb
+ * The tgdb instance, the data is left in tgdb->read_buffer
+ *
+ * @param fd
+ * The file descriptor to read
+ *
+ * @return
+ * The number of bytes read, 0 on EOF or -1 on error. If nothing was
+ * available, -1 is returned and errno is EAGAIN.
+ */
+static ssize_t tgdb_read_available(struct tgdb *tgdb, int fd)
+{
+    size_t used = 0;
+
+    for (;;) {
+        ssize_t size;
 
-    // Remove everything up to the last newline character so that
-    // only newly added new lines are searched
-    size_t pos = tgdb->undefined_new_ui_command->find_last_of("\n");
-    if (pos != std::string::npos) {
-        *tgdb->undefined_new_ui_command = 
-                tgdb->undefined_new_ui_command->substr(pos);
+        if (used == tgdb->read_buffer_size) {
+            if (tgdb->read_buffer_size >= TGDB_READ_BUFFER_MAX) {
+                break;
+            }
+            tgdb->read_buffer_size *= 2;
+            tgdb->read_buffer = (char *)cgdb_realloc(tgdb->read_buffer,
+                    tgdb->read_buffer_size);
+        }
+
+        size = read(fd, tgdb->read_buffer + used,
+                tgdb->read_buffer_size - used);
+        if (size > 0) {
+            used += size;
+        } else if (size == -1 && errno == EINTR) {
+            continue;
+        } else if (size == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (used == 0) {
+                return -1;
+            }
+            break;
+        } else if (size == 0 || errno == EIO) {
+            // EOF, which a pty reports as EIO. Let the next call see it.
+            if (used == 0) {
+                return 0;
+            }
+            break;
+        } else {
+            clog_error(CLOG_CGDB, "error reading from fd: %s",
+                    strerror(errno));
+            return -1;
+        }
     }
+
+    return used;
 }
 
 int tgdb_process(struct tgdb * tgdb, int fd)
 {
-    const int n = 4096;
-    static char buf[n];
     ssize_t size;
     int result = 0;
 
     // If ^c has been typed at the prompt, clear the queues
     tgdb_handle_control_c(tgdb);
 
-    size = io_read(fd, buf, n);
-    if (size < 0) {
+    size = tgdb_read_available(tgdb, fd);
+    if (size == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        // Nothing to read after all
+    } else if (size < 0) {
         // Error reading from GDB
         clog_error(CLOG_CGDB, "Error reading from gdb's stdout, closing down");
         result = -1;
@@ -1107,27 +3454,45 @@ int tgdb_process(struct tgdb * tgdb, int fd)
         clog_info(CLOG_GDBIO, "read EOF from GDB, closing down");
         tgdb_add_quit_command(tgdb, false);
     } else {
+        const char *buf = tgdb->read_buffer;
+
+        tgdb_session_record(tgdb,
+                fd == tgdb->gdb_mi_ui_fd ? 'm' : 'c', buf, size);
+
         if (fd == tgdb->debugger_stdout) {
             // Read some GDB console output, process it
-            std::string str = sys_quote_nonprintables(buf, size);
-            clog_debug(CLOG_GDBIO, "%s", str.c_str());
-            std::string msg(buf, size);
+            if (clog_enabled(CLOG_GDBIO_ID, CLOG_DEBUG)) {
+                std::string str = sys_quote_nonprintables(buf, size);
+                clog_debug(CLOG_GDBIO, "%s", str.c_str());
+            }
 
             // Determine if this gdb supports the new-ui command.
             // If it does not, send the quit command to alert the user
             // that they need a newer gdb.
-            tgdb_search_for_unsupported_new_ui_message(tgdb, msg);
+            tgdb_search_console_output(tgdb, buf, size);
             if (!tgdb->gdb_supports_new_ui_command) {
                 tgdb_add_quit_command(tgdb, true);
             }
 
             tgdb->callbacks.console_output_callback(
-                    tgdb->callbacks.context, msg);
+                    tgdb->callbacks.context, buf, size);
         } else if (fd == tgdb->gdb_mi_ui_fd){
-            // Read some GDB console output, process it
-            std::string msg(buf, size);
-            clog_debug(CLOG_GDBMIIO, "%s", msg.c_str());
-            tgdb_commands_process(tgdb, msg);
+            // GDB runs mi commands in order, so this output is at least
+            // in part for the oldest command still waiting for a result
+            tgdb->mi_read_time = tgdb_time_usec();
+            if (!tgdb->pending_requests->empty()) {
+                tgdb_request_ptr request =
+                    tgdb->pending_requests->begin()->second;
+                if (!request->first_byte_time) {
+                    request->first_byte_time = tgdb->mi_read_time;
+                }
+            }
+
+            // Read some GDB mi output, process it
+            if (clog_enabled(CLOG_GDBMIIO_ID, CLOG_DEBUG)) {
+                clog_debug(CLOG_GDBMIIO, "%.*s", (int)size, buf);
+            }
+            gdbwire_push_data(tgdb->wire, buf, size);
         } else {
         }
     }
@@ -1137,17 +3502,34 @@ int tgdb_process(struct tgdb * tgdb, int fd)
 
 /* Getting Data out of TGDB {{{*/
 
-struct tgdb_response *tgdb_create_response(enum tgdb_response_type header)
+/**
+ * Create a response, reusing a sent one if there is one.
+ *
+ * A TGDB_UPDATE_FILE_POSITION response comes with its file position.
+ */
+struct tgdb_response *tgdb_create_response(struct tgdb *tgdb,
+        enum tgdb_response_type header)
 {
-    struct tgdb_response *response;
+    struct tgdb_response_slot *slot;
+
+    if (sbcount(tgdb->response_pool) > 0) {
+        slot = sbpop(tgdb->response_pool);
+        memset(slot, 0, sizeof(struct tgdb_response_slot));
+    } else {
+        slot = (struct tgdb_response_slot *)cgdb_calloc(1,
+                sizeof(struct tgdb_response_slot));
+    }
 
-    response = (struct tgdb_response *)cgdb_calloc(1, sizeof(struct tgdb_response));
-    response->header = header;
+    slot->response.header = header;
+    if (header == TGDB_UPDATE_FILE_POSITION) {
+        slot->response.choice.update_file_position.file_position =
+            &slot->file_position;
+    }
 
-    return response;
+    return &slot->response;
 }
 
-static int tgdb_delete_response(struct tgdb_response *com)
+static int tgdb_delete_response(struct tgdb *tgdb, struct tgdb_response *com)
 {
     if (!com)
         return -1;
@@ -1155,45 +3537,31 @@ static int tgdb_delete_response(struct tgdb_response *com)
     switch (com->header) {
         case TGDB_UPDATE_BREAKPOINTS:
         {
-            int i;
-            struct tgdb_breakpoint *breakpoints =
-                com->choice.update_breakpoints.breakpoints;
-
-            for (i = 0; i < sbcount(breakpoints); i++) {
-
-                struct tgdb_breakpoint *tb = &breakpoints[i];
-
-                free(tb->path);
-            }
-
-            sbfree(breakpoints);
+            tgdb_breakpoints_free(com->choice.update_breakpoints.breakpoints);
             com->choice.update_breakpoints.breakpoints = NULL;
             break;
         }
+        case TGDB_UPDATE_BREAKPOINT_CHANGES:
+        {
+            tgdb_breakpoints_free(
+                    com->choice.update_breakpoint_changes.removed);
+            tgdb_breakpoints_free(
+                    com->choice.update_breakpoint_changes.added);
+            com->choice.update_breakpoint_changes.removed = NULL;
+            com->choice.update_breakpoint_changes.added = NULL;
+            break;
+        }
         case TGDB_UPDATE_FILE_POSITION:
         {
-            struct tgdb_file_position *tfp =
-                    com->choice.update_file_position.file_position;
-
-            free(tfp->path);
-            free(tfp->from);
-            free(tfp->func);
-
-            free(tfp);
-
+            // The file position is part of the response slot and its
+            // strings are interned
             com->choice.update_file_position.file_position = NULL;
             break;
         }
         case TGDB_UPDATE_SOURCE_FILES:
         {
-            int i;
-            char **source_files = com->choice.update_source_files.source_files;
-
-            for (i = 0; i < sbcount(source_files); i++) {
-                free(source_files[i]);
-            }
-            sbfree(source_files);
-
+            tgdb_source_files_free(
+                    com->choice.update_source_files.source_files);
             com->choice.update_source_files.source_files = NULL;
             break;
         }
@@ -1213,8 +3581,13 @@ static int tgdb_delete_response(struct tgdb_response *com)
             break;
     }
 
-    free(com);
-    com = NULL;
+    // The response is the first member of its slot
+    if (sbcount(tgdb->response_pool) < TGDB_POOL_MAX) {
+        sbpush(tgdb->response_pool, (struct tgdb_response_slot *)com);
+    } else {
+        free(com);
+    }
+
     return 0;
 }
 
@@ -1222,7 +3595,7 @@ void tgdb_send_response(struct tgdb *tgdb, struct tgdb_response *response)
 {
     tgdb->callbacks.command_response_callback(
             tgdb->callbacks.context, response);
-    tgdb_delete_response(response);
+    tgdb_delete_response(tgdb, response);
 }
 
 int tgdb_resize_console(struct tgdb *tgdb, int rows, int cols)
@@ -1257,33 +3630,48 @@ void tgdb_request_inferiors_source_files(struct tgdb * tgdb)
 {
     tgdb_request_ptr request_ptr;
 
-    request_ptr = (tgdb_request_ptr)cgdb_malloc(sizeof (struct tgdb_request));
+    tgdb_session_record_request(tgdb, "inferiors_source_files");
+
+    if (tgdb->source_files_valid) {
+        tgdb_commands_send_source_files(tgdb);
+        return;
+    }
+
+    tgdb->source_files_wanted = true;
 
-    request_ptr->header = TGDB_REQUEST_INFO_SOURCES;
+    request_ptr = tgdb_request_create(tgdb, TGDB_REQUEST_INFO_SOURCES);
+
+    // A request written to gdb since the symbols last changed will
+    // have the current list, the front end just has to wait for it
+    if (!tgdb->source_files_stale &&
+            tgdb_request_in_flight(tgdb, request_ptr)) {
+        tgdb_request_destroy(tgdb, request_ptr);
+        return;
+    }
 
-    tgdb_run_or_queue_request(tgdb, request_ptr, false);
+    tgdb_run_or_queue_request(tgdb, request_ptr, TGDB_PRIORITY_USER);
 }
 
 void tgdb_request_current_location(struct tgdb * tgdb)
 {
     tgdb_request_ptr request_ptr;
 
-    request_ptr = (tgdb_request_ptr)cgdb_malloc(sizeof (struct tgdb_request));
+    tgdb_session_record_request(tgdb, "current_location");
 
-    request_ptr->header = TGDB_REQUEST_INFO_FRAME;
+    request_ptr = tgdb_request_create(tgdb, TGDB_REQUEST_INFO_FRAME);
 
-    tgdb_run_or_queue_request(tgdb, request_ptr, true);
+    tgdb_run_or_queue_request(tgdb, request_ptr, TGDB_PRIORITY_STATE);
 }
 
 void tgdb_request_breakpoints(struct tgdb * tgdb)
 {
     tgdb_request_ptr request_ptr;
 
-    request_ptr = (tgdb_request_ptr)cgdb_malloc(sizeof (struct tgdb_request));
+    tgdb_session_record_request(tgdb, "breakpoints");
 
-    request_ptr->header = TGDB_REQUEST_BREAKPOINTS;
+    request_ptr = tgdb_request_create(tgdb, TGDB_REQUEST_BREAKPOINTS);
 
-    tgdb_run_or_queue_request(tgdb, request_ptr, false);
+    tgdb_run_or_queue_request(tgdb, request_ptr, TGDB_PRIORITY_USER);
 }
 
 void
@@ -1291,12 +3679,12 @@ tgdb_request_run_debugger_command(struct tgdb * tgdb, enum tgdb_command_type c)
 {
     tgdb_request_ptr request_ptr;
 
-    request_ptr = (tgdb_request_ptr)cgdb_malloc(sizeof (struct tgdb_request));
+    tgdb_session_record_request(tgdb, "run_debugger_command %d", c);
 
-    request_ptr->header = TGDB_REQUEST_DEBUGGER_COMMAND;
+    request_ptr = tgdb_request_create(tgdb, TGDB_REQUEST_DEBUGGER_COMMAND);
     request_ptr->choice.debugger_command.c = c;
 
-    tgdb_run_or_queue_request(tgdb, request_ptr, false);
+    tgdb_run_or_queue_request(tgdb, request_ptr, TGDB_PRIORITY_USER);
 }
 
 void
@@ -1305,41 +3693,61 @@ tgdb_request_modify_breakpoint(struct tgdb *tgdb, const char *file, int line,
 {
     tgdb_request_ptr request_ptr;
 
-    request_ptr = (tgdb_request_ptr)cgdb_malloc(sizeof (struct tgdb_request));
+    // The file goes last since it may contain spaces
+    tgdb_session_record_request(tgdb,
+            "modify_breakpoint %d 0x%" PRIx64 " %d %s",
+            line, addr, b, file ? file : "");
 
-    request_ptr->header = TGDB_REQUEST_MODIFY_BREAKPOINT;
-    request_ptr->choice.modify_breakpoint.file = file ? cgdb_strdup(file) : NULL;
+    request_ptr = tgdb_request_create(tgdb, TGDB_REQUEST_MODIFY_BREAKPOINT);
+    request_ptr->choice.modify_breakpoint.file = tgdb_intern(tgdb, file);
     request_ptr->choice.modify_breakpoint.line = line;
     request_ptr->choice.modify_breakpoint.addr = addr;
     request_ptr->choice.modify_breakpoint.b = b;
 
-    tgdb_run_or_queue_request(tgdb, request_ptr, false);
+    tgdb_run_or_queue_request(tgdb, request_ptr, TGDB_PRIORITY_USER);
 }
 
-void tgdb_request_disassemble_pc(struct tgdb *tgdb, int lines)
+void tgdb_request_disassemble_pc(struct tgdb *tgdb, uint64_t addr, int lines)
 {
     tgdb_request_ptr request_ptr;
 
-    request_ptr = (tgdb_request_ptr)cgdb_malloc(sizeof (struct tgdb_request));
-    request_ptr->header = TGDB_REQUEST_DISASSEMBLE_PC;
+    tgdb_session_record_request(tgdb,
+            "disassemble_pc 0x%" PRIx64 " %d", addr, lines);
+
+    if (tgdb_send_disassemble_pc(tgdb, addr, lines, false)) {
+        return;
+    }
+
+    request_ptr = tgdb_request_create(tgdb, TGDB_REQUEST_DISASSEMBLE_PC);
 
+    request_ptr->choice.disassemble.addr = addr;
     request_ptr->choice.disassemble.lines = lines;
 
-    tgdb_run_or_queue_request(tgdb, request_ptr, false);
+    tgdb_run_or_queue_request(tgdb, request_ptr, TGDB_PRIORITY_USER);
 }
 
-void tgdb_request_disassemble_func(struct tgdb *tgdb,
+void tgdb_request_disassemble_func(struct tgdb *tgdb, uint64_t addr,
         enum disassemble_func_type type)
 {
     tgdb_request_ptr request_ptr;
+    int raw = (type == DISASSEMBLE_FUNC_RAW_INSTRUCTIONS);
+    int source = (type == DISASSEMBLE_FUNC_SOURCE_LINES) &&
+        tgdb_commands_disassemble_supports_s_mode(tgdb);
+
+    tgdb_session_record_request(tgdb,
+            "disassemble_func 0x%" PRIx64 " %d", addr, type);
+
+    if (tgdb_send_disassemble_func(tgdb, addr, source, raw)) {
+        return;
+    }
 
-    request_ptr = (tgdb_request_ptr)cgdb_malloc(sizeof (struct tgdb_request));
-    request_ptr->header = TGDB_REQUEST_DISASSEMBLE_FUNC;
+    request_ptr = tgdb_request_create(tgdb, TGDB_REQUEST_DISASSEMBLE_FUNC);
 
-    request_ptr->choice.disassemble_func.raw = (type == DISASSEMBLE_FUNC_RAW_INSTRUCTIONS);
-    request_ptr->choice.disassemble_func.source = (type == DISASSEMBLE_FUNC_SOURCE_LINES);
+    request_ptr->choice.disassemble_func.addr = addr;
+    request_ptr->choice.disassemble_func.raw = raw;
+    request_ptr->choice.disassemble_func.source = source;
 
-    tgdb_run_or_queue_request(tgdb, request_ptr, false);
+    tgdb_run_or_queue_request(tgdb, request_ptr, TGDB_PRIORITY_USER);
 }
 
 /* }}}*/
@@ -1378,6 +3786,9 @@ int tgdb_get_gdb_command(struct tgdb *tgdb, tgdb_request_ptr request,
         case TGDB_REQUEST_DATA_DISASSEMBLE_MODE_QUERY:
             command = "-data-disassemble -s 0 -e 0 -- 4\n";
             break;
+        case TGDB_REQUEST_DATA_DISASSEMBLE_FUNC_QUERY:
+            command = "-data-disassemble -a 0 -- 0\n";
+            break;
         case TGDB_REQUEST_DEBUGGER_COMMAND:
             command = tgdb_get_client_command(tgdb,
                     request->choice.debugger_command.c);
@@ -1394,46 +3805,42 @@ int tgdb_get_gdb_command(struct tgdb *tgdb, tgdb_request_ptr request,
             str = NULL;
             break;
         case TGDB_REQUEST_DISASSEMBLE_PC:
-            str = sys_aprintf("x/%di $pc\n", request->choice.disassemble.lines);
+            str = sys_aprintf("-data-disassemble -s 0x%" PRIx64
+                    " -e 0x%" PRIx64 " -- %d\n",
+                    request->choice.disassemble.addr,
+                    request->choice.disassemble.addr +
+                        (uint64_t)request->choice.disassemble.lines *
+                            TGDB_DISASSEMBLE_BYTES_PER_LINE,
+                    tgdb_disassemble_mode(tgdb));
             command = str;
             free(str);
             str = NULL;
             break;
-        case TGDB_REQUEST_DISASSEMBLE_FUNC: {
-            /* GDB 7.11 adds /s command to disassemble
-
-            https://sourceware.org/git/gitweb.cgi?p=binutils-gdb.git;a=commit;h=6ff0ba5f7b8a2b10642bbb233a32043595c55670
-                The "source centric" /m option to the disassemble command is
-                often unhelpful, e.g., in the presence of optimized code.
-                This patch adds a /s modifier that is better.
-                For one, /m only prints instructions from the originating
-                source file, leaving out instructions from
-                e.g., inlined functions from other files.
-
-            disassemble
-                 /m: source lines included
-                 /s: source lines included, output in pc order (7.10 and higher)
-                 /r: raw instructions included in hex
-                 single argument: function surrounding is dumped
-                 two arguments: start,end or start,+length
-                 disassemble 'driver.cpp'::main
-                 interp mi "disassemble /s 'driver.cpp'::main,+10"
-                 interp mi "disassemble /r 'driver.cpp'::main,+10"
-             */
-            const char *data = NULL;
-            if (request->choice.disassemble_func.raw) {
-                data = "/r";
-            } else if (request->choice.disassemble_func.source &&
-                    tgdb_commands_disassemble_supports_s_mode(tgdb)) {
-                data = "/s";
+        case TGDB_REQUEST_DISASSEMBLE_FUNC:
+            if (tgdb->disassemble_supports_a_option) {
+                /* The -a option disassembles the whole function surrounding
+                 * the address. The same instructions are fetched no matter
+                 * how they will be displayed, see tgdb_disassemble_mode. */
+                str = sys_aprintf("-data-disassemble -a 0x%" PRIx64 " -- %d\n",
+                        request->choice.disassemble_func.addr,
+                        tgdb_disassemble_mode(tgdb));
+            } else {
+                /* Without -a, only the CLI disassemble command knows where
+                 * the function starts and ends. Its output is scraped, see
+                 * tgdb_disassemble_cli_line. */
+                const char *modifier = "";
+                if (request->choice.disassemble_func.raw) {
+                    modifier = " /r";
+                } else if (request->choice.disassemble_func.source) {
+                    modifier = " /s";
+                }
+                str = sys_aprintf("disassemble%s 0x%" PRIx64 "\n", modifier,
+                        request->choice.disassemble_func.addr);
             }
-            str = sys_aprintf("disassemble%s%s\n",
-                    data ? " " : "", data ? data : "");
             command = str;
             free(str);
             str = NULL;
             break;
-        }
     }
 
     return 0;
@@ -1450,16 +3857,27 @@ int tgdb_signal_notification(struct tgdb *tgdb, int signum)
     struct termios t;
     cc_t *sig_char = NULL;
 
-    tcgetattr(tgdb->debugger_stdin, &t);
+    tgdb_session_record_request(tgdb, "signal_notification %d", signum);
+
+    // The console is not a terminal when it was connected with
+    // tgdb_connect_gdb, use the usual characters then
+    if (tcgetattr(tgdb->debugger_stdin, &t) == -1) {
+        t.c_cc[VINTR] = 003;
+        t.c_cc[VQUIT] = 034;
+    }
 
     if (signum == SIGINT) {     /* ^c */
         tgdb->control_c = 1;
         sig_char = &t.c_cc[VINTR];
-        if (write(tgdb->debugger_stdin, sig_char, 1) < 1)
+        tgdb_session_record(tgdb, 'C', (const char *)sig_char, 1);
+        if (tgdb_write(tgdb, tgdb->debugger_stdin,
+                    (const char *)sig_char, 1) == -1)
             return -1;
     } else if (signum == SIGQUIT) { /* ^\ */
         sig_char = &t.c_cc[VQUIT];
-        if (write(tgdb->debugger_stdin, sig_char, 1) < 1)
+        tgdb_session_record(tgdb, 'C', (const char *)sig_char, 1);
+        if (tgdb_write(tgdb, tgdb->debugger_stdin,
+                    (const char *)sig_char, 1) == -1)
             return -1;
     } else if (signum == SIGCHLD) {
         // GDB has died, clean up the zombie and send the quit command
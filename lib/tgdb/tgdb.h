@@ -52,7 +52,10 @@
          //
          // This will usually be absolute. If the absolute path is not
          // available for GDB it will be a relative path
-        char *path;
+         //
+         // The path belongs to tgdb and stays valid until tgdb_shutdown.
+         // The same path is always the same pointer.
+        const char *path;
 
         // The line number where the breakpoint is set
         int line;
@@ -78,7 +81,10 @@
          // available for GDB it will be a relative path.
          //
          // Will be NULL if the source information is not available
-        char *path;
+         //
+         // Like the strings below, the path belongs to tgdb and stays
+         // valid until tgdb_shutdown.
+        const char *path;
 
         // The line number in the file or 0 if unknown
         int line_number;
@@ -87,10 +93,10 @@
         uint64_t addr;
 
         // Shared library where this function is defined or NULL if unknown
-        char *from;
+        const char *from;
 
         // Function name or NULL if unknown
-        char *func;
+        const char *func;
     };
 
     enum tgdb_request_type {
@@ -142,6 +148,24 @@
         // This functionality was added in gdb in commit 6ff0ba5f.
         TGDB_REQUEST_DATA_DISASSEMBLE_MODE_QUERY,
 
+        // Query if the MI -data-disassemble command supports the -a option,
+        // which disassembles the whole function surrounding an address.
+        //
+        // There is no function at address 0, so the command always fails.
+        // The error message tells the two cases apart.
+        //
+        // The passing case,
+        //   (gdb) interpreter-exec mi "-data-disassemble -a 0 -- 0"
+        //   ^error,msg="No function contains specified address."
+        //
+        // The failing case,
+        //   (gdb) interpreter-exec mi "-data-disassemble -a 0 -- 0"
+        //   ^error,msg="-data-disassemble: Unknown option ``a''"
+        //
+        // If -a is not supported, functions are disassembled with the CLI
+        // disassemble command instead.
+        TGDB_REQUEST_DATA_DISASSEMBLE_FUNC_QUERY,
+
         // Run a debugger command through gdb.
         // 
         // This is when the caller wants to run a command through gdb,
@@ -170,6 +194,10 @@
         // All breakpoints that are set
         TGDB_UPDATE_BREAKPOINTS,
 
+        // Breakpoints that were added, changed or deleted since the
+        // last TGDB_UPDATE_BREAKPOINTS or TGDB_UPDATE_BREAKPOINT_CHANGES
+        TGDB_UPDATE_BREAKPOINT_CHANGES,
+
         // This tells the gui what filename/line number the debugger is on.
         // It gets generated whenever it changes.
         // This is a 'struct tgdb_file_position *'.
@@ -204,6 +232,21 @@
                 struct tgdb_breakpoint *breakpoints;
             } update_breakpoints;
 
+            // header == TGDB_UPDATE_BREAKPOINT_CHANGES
+            //
+            // A changed breakpoint shows up as its old locations in removed
+            // and its new locations in added. Apply removed first.
+            //
+            // If a removed location is still covered by another breakpoint,
+            // that breakpoint is listed in added as well.
+            struct {
+                // Breakpoint locations that should no longer be marked
+                struct tgdb_breakpoint *removed;
+
+                // Breakpoint locations that should be marked
+                struct tgdb_breakpoint *added;
+            } update_breakpoint_changes;
+
             // header == TGDB_UPDATE_FILE_POSITION
             struct {
                 struct tgdb_file_position *file_position;
@@ -213,7 +256,8 @@
             struct {
                 // This list has elements of 'const char *' representing each 
                 // filename. The filename may be relative or absolute.
-                char **source_files;
+                // The filenames belong to tgdb, as with breakpoint paths.
+                const char **source_files;
             } update_source_files;
 
             // header == TGDB_INFERIOR_EXITED
@@ -270,10 +314,14 @@
          * @param context
          * The context pointer
          *
-         * @param str
-         * The console output
+         * @param data
+         * The console output. It is only valid during the callback.
+         *
+         * @param size
+         * The number of bytes of console output
          */
-        void (*console_output_callback)(void *context, const std::string &str);
+        void (*console_output_callback)(void *context, const char *data,
+                size_t size);
 
         /**
          * A command response is available for consumption.
@@ -363,6 +411,51 @@
             int gdb_win_rows, int gdb_win_cols, int *gdb_console_fd,
             int *gdb_mi_fd);
 
+    // Talk to a debugger over file descriptors that are already open,
+    // instead of starting one.
+    //
+    // Used to replay a recorded session with something standing in
+    // for gdb. Call this instead of tgdb_start_gdb.
+    //
+    // @param tgdb
+    // An instance of the tgdb library to operate on.
+    //
+    // @param console_fd
+    // The gdb console, read from and written to
+    //
+    // @param mi_fd
+    // The gdb machine interface, read from and written to
+    //
+    // @return
+    // 0 on success or -1 on error
+    int tgdb_connect_gdb(struct tgdb *tgdb, int console_fd, int mi_fd);
+
+    // The first line of a session file written by tgdb_record_session
+    #define TGDB_SESSION_HEADER "tgdb session 1"
+
+    // Record everything tgdb reads from and writes to gdb, and every
+    // call the front end makes into tgdb, to a file.
+    //
+    // After the TGDB_SESSION_HEADER line, the file is a list of records.
+    // Each one is a line "TIME STREAM SIZE", followed by SIZE bytes of
+    // data and a newline. TIME is in microseconds since the recording
+    // started. STREAM is one of,
+    //   c - output read from the gdb console
+    //   m - output read from the gdb machine interface
+    //   C - input written to the gdb console
+    //   M - input written to the gdb machine interface
+    //   R - a front end call, its name and arguments separated by spaces
+    //
+    // @param tgdb
+    // An instance of the tgdb library to operate on.
+    //
+    // @param path
+    // The file to write the session to
+    //
+    // @return
+    // 0 on success or -1 on error
+    int tgdb_record_session(struct tgdb *tgdb, const char *path);
+
   /**
    * This function does most of the dirty work in TGDB. It is capable of 
    * processing the output of the debugger, to either satisfy a previously 
@@ -382,6 +475,39 @@
    */
     int tgdb_process(struct tgdb *tgdb, int fd);
 
+    /**
+     * Get how much data is waiting to be written to gdb.
+     *
+     * TGDB never blocks writing to gdb. When gdb is not reading its input,
+     * commands and characters are queued until it does. While data is
+     * queued for a file descriptor, the caller should wait for it to
+     * become writable and then call tgdb_process_writable.
+     *
+     * \param tgdb
+     * An instance of the tgdb library to operate on.
+     *
+     * \param fd
+     * The console or mi file descriptor.
+     *
+     * \return
+     * The number of bytes waiting to be written to fd.
+     */
+    size_t tgdb_pending_write_size(struct tgdb *tgdb, int fd);
+
+    /**
+     * Write the data queued for gdb, as much as gdb will accept.
+     *
+     * \param tgdb
+     * An instance of the tgdb library to operate on.
+     *
+     * \param fd
+     * The file descriptor that is writable (either the console or mi).
+     *
+     * \return
+     * 0 on sucess, or -1 on error
+     */
+    int tgdb_process_writable(struct tgdb *tgdb, int fd);
+
     /**
      * Send a character to the gdb console.
      *
@@ -413,6 +539,23 @@
      */
     int tgdb_resize_console(struct tgdb *tgdb, int rows, int cols);
 
+    /**
+     * Get how long the requests tgdb sent to gdb took.
+     *
+     * For each request type, this has the count, median, 99th percentile
+     * and maximum time spent queued in tgdb, waiting for gdb to start
+     * answering, reading the answer, and processing it.
+     *
+     * The same table is written to the cgdb log when tgdb shuts down.
+     *
+     * \param tgdb
+     * An instance of the tgdb library to operate on.
+     *
+     * \return
+     * A table with one line per request type and stage.
+     */
+    std::string tgdb_get_request_stats(struct tgdb *tgdb);
+
 /*@}*/
 /* }}}*/
 
@@ -429,6 +572,11 @@
   /**
    * Gets a list of source files that make up the program being debugged.
    *
+   * The list is fetched in the background when gdb loads symbols and
+   * kept up to date as libraries are loaded and unloaded. If it is
+   * current, the TGDB_UPDATE_SOURCE_FILES response is sent right away
+   * without asking gdb.
+   *
    * \param tgdb
    * An instance of the tgdb library to operate on.
    */
@@ -488,26 +636,42 @@
     /**
      * Used to get the disassemble of the current $pc.
      *
+     * Instructions that were already disassembled are answered from a
+     * cache without asking gdb.
+     *
      * \param tgdb
      * An instance of the tgdb library to operate on.
      *
+     * \param addr
+     * The address to disassemble from, usually the $pc.
+     *
      * \param lines
      * The number of lines to disassemble after the pc.
      */
-    void tgdb_request_disassemble_pc(struct tgdb *tgdb, int lines);
+    void tgdb_request_disassemble_pc(struct tgdb *tgdb, uint64_t addr,
+            int lines);
 
    /**
     * Get disassembly for entire function.
     *
+    * Functions that were already disassembled are answered from a
+    * cache without asking gdb.
+    *
     * \param tgdb
     * An instance of the tgdb library to operate on.
+    *
+    * \param addr
+    * An address in the function, usually the $pc.
+    *
+    * \param type
+    * What to show along with the instructions.
     */
     enum disassemble_func_type {
         DISASSEMBLE_FUNC_DISASSEMBLY,
         DISASSEMBLE_FUNC_SOURCE_LINES,
         DISASSEMBLE_FUNC_RAW_INSTRUCTIONS,
     };
-    void tgdb_request_disassemble_func(struct tgdb *tgdb,
+    void tgdb_request_disassemble_func(struct tgdb *tgdb, uint64_t addr,
             enum disassemble_func_type type);
 
 /*@}*/
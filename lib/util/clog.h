@@ -190,6 +190,28 @@ void clog_error(const char *sfile, int sline, int id, const char *fmt, ...) ATTR
  */
 int clog_set_level(int id, enum clog_level level);
 
+/**
+ * Determine if a logger would write a message at the given level.
+ *
+ * This is a macro so that it is cheap enough to guard log calls whose
+ * arguments are expensive to build, e.g.:
+ *
+ *     if (clog_enabled(MY_LOGGER_ID, CLOG_DEBUG)) {
+ *         clog_debug(CLOG(MY_LOGGER_ID), "%s", expensive_to_format());
+ *     }
+ *
+ * @param id
+ * The identifier of the logger.
+ *
+ * @param lvl
+ * The level the message would be logged at.
+ *
+ * @return
+ * Non-zero if the logger exists and accepts messages at this level.
+ */
+#define clog_enabled(id, lvl) \
+    (_clog_loggers[(id)] != NULL && (lvl) >= _clog_loggers[(id)]->level)
+
 /**
  * Set the format string used for times.  See strftime(3) for how this string
  * should be defined.  The default format string is CLOG_DEFAULT_TIME_FORMAT.
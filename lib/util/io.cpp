@@ -72,6 +72,19 @@ static void process_error(void)
         clog_error(CLOG_CGDB, "ERRNO = EFAULT");
 }
 
+/* Wait until a non-blocking fd that was full can be written again */
+static void io_wait_writable(int fd)
+{
+#if defined(HAVE_SYS_SELECT_H)
+    fd_set writefds;
+
+    FD_ZERO(&writefds);
+    FD_SET(fd, &writefds);
+
+    select(fd + 1, (fd_set *) NULL, &writefds, (fd_set *) NULL, NULL);
+#endif
+}
+
 int io_read_byte(char *c, int source)
 {
     int ret_val = 0;
@@ -89,7 +102,7 @@ int io_read_byte(char *c, int source)
 
 int io_write_byte(int dest, char c)
 {
-    if (write(dest, &c, 1) != 1)
+    if (io_writen(dest, &c, 1) != 1)
         return -1;
 
     return 0;
@@ -144,9 +157,13 @@ ssize_t io_writen(int fd, const void *vptr, size_t n)
 
     while (nleft > 0) {
         if ((nwritten = write(fd, ptr, nleft)) <= 0) {
-            if (errno == EINTR)
+            if (nwritten == -1 && errno == EINTR)
+                nwritten = 0;
+            else if (nwritten == -1 &&
+                    (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                io_wait_writable(fd);
                 nwritten = 0;
-            else
+            } else
                 return -1;
         }
         nleft -= nwritten;
@@ -156,6 +173,18 @@ ssize_t io_writen(int fd, const void *vptr, size_t n)
     return (n);
 }
 
+int io_set_nonblocking(int fd)
+{
+    int flag = fcntl(fd, F_GETFL, 0);
+
+    if (flag == -1 || fcntl(fd, F_SETFL, flag | O_NONBLOCK) == -1) {
+        clog_error(CLOG_CGDB, "fcntl failed: %s", strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
 void io_display_char(FILE * fd, char c)
 {
     if (c == '\r')
@@ -28,7 +28,15 @@ int io_rw_byte(int source, int dest);
  */
 ssize_t io_read(int fd, void *buf, size_t count);
 
+/* io_set_nonblocking: Puts fd in non-blocking mode.
+ *          Returns: 0 on success, -1 on error.
+ */
+int io_set_nonblocking(int fd);
+
 /* io_writen: This will write n bytes of vptr to fd. 
+ *
+ *     If fd is non-blocking, this waits for it to become writable
+ *     whenever it is full, so all n bytes are still written.
  *
  *     It receives:
  *         fd     - The file descriptor to write to.
@@ -1,5 +1,11 @@
 #include "vterm_internal.h"
 
+#if defined(__AVX2__)
+# include <immintrin.h>
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
 #define UNICODE_INVALID 0xFFFD
 
 #if defined(DEBUG) && DEBUG > 1
@@ -17,6 +23,69 @@ struct UTF8DecoderData {
   int this_cp;
 };
 
+/* Returns the length of the run of printable ASCII (0x20 to 0x7e) at the
+ * start of bytes. This is the bulk of what a terminal is ever sent, so the
+ * scan is done 32 or 16 bytes at a time where the compiler allows it.
+ */
+INTERNAL size_t vterm_ascii_span(const char bytes[], size_t len)
+{
+  size_t pos = 0;
+
+#if defined(__AVX2__)
+  const __m256i avx_lo = _mm256_set1_epi8(0x1f);
+  const __m256i avx_hi = _mm256_set1_epi8(0x7f);
+
+  for(; pos + 32 <= len; pos += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(bytes + pos));
+    /* Bytes >= 0x80 are negative as signed chars, so they fail the lo test */
+    __m256i ok = _mm256_and_si256(_mm256_cmpgt_epi8(v, avx_lo),
+                                  _mm256_cmpgt_epi8(avx_hi, v));
+    unsigned int mask = (unsigned int)_mm256_movemask_epi8(ok);
+    if(mask != 0xffffffffu)
+      return pos + __builtin_ctz(~mask);
+  }
+#endif
+
+#if defined(__SSE2__)
+  const __m128i sse_lo = _mm_set1_epi8(0x1f);
+  const __m128i sse_hi = _mm_set1_epi8(0x7f);
+
+  for(; pos + 16 <= len; pos += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(bytes + pos));
+    __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, sse_lo),
+                               _mm_cmpgt_epi8(sse_hi, v));
+    unsigned int mask = (unsigned int)_mm_movemask_epi8(ok);
+    if(mask != 0xffff)
+      return pos + __builtin_ctz(~mask);
+  }
+#endif
+
+  for(; pos < len; pos++) {
+    unsigned char c = bytes[pos];
+    if(c < 0x20 || c >= 0x7f)
+      break;
+  }
+
+  return pos;
+}
+
+/* Widens the printable ASCII run following bytes[*pos] into cp[], for
+ * decoders that map printable ASCII onto itself. *pos is left on the last
+ * byte copied, as the decode loops advance it themselves.
+ */
+static void decode_ascii_run(uint32_t cp[], int *cpi, int cplen,
+                             const char bytes[], size_t *pos, size_t bytelen)
+{
+  size_t room = *cpi < cplen ? (size_t)(cplen - *cpi) : 0;
+  size_t avail = bytelen - *pos - 1;
+  size_t run = vterm_ascii_span(bytes + *pos + 1, avail < room ? avail : room);
+
+  for(size_t i = 1; i <= run; i++)
+    cp[(*cpi)++] = (unsigned char)bytes[*pos + i];
+
+  *pos += run;
+}
+
 static void init_utf8(VTermEncoding *enc, void *data_)
 {
   struct UTF8DecoderData *data = data_;
@@ -54,6 +123,8 @@ static void decode_utf8(VTermEncoding *enc, void *data_,
       printf(" UTF-8 char: U+%04x\n", c);
 #endif
       data->bytes_remaining = 0;
+
+      decode_ascii_run(cp, cpi, cplen, bytes, pos, bytelen);
     }
 
     else if(c == 0x7f) // DEL
@@ -172,6 +243,9 @@ static void decode_usascii(VTermEncoding *enc, void *data,
       return;
 
     cp[(*cpi)++] = c;
+
+    if(!is_gr)
+      decode_ascii_run(cp, cpi, cplen, bytes, pos, bytelen);
   }
 }
 
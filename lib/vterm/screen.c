@@ -61,6 +61,12 @@ struct VTermScreen
   /* buffer will == buffers[0] or buffers[1], depending on altscreen */
   ScreenCell *buffer;
 
+  /* buffer is a ring of rows, screen row 0 is stored at buffer row top. This
+   * lets a full screen scroll rotate top rather than move every cell. The
+   * inactive buffer is always kept unrotated, with its top at row 0.
+   */
+  int top;
+
   /* buffer for a single screen row used in scrollback storage callbacks */
   VTermScreenCell *sb_buffer;
 
@@ -79,7 +85,12 @@ static inline ScreenCell *getcell(const VTermScreen *screen, int row, int col)
     return NULL;
   if(col < 0 || col >= screen->cols)
     return NULL;
-  return screen->buffer + (screen->cols * row) + col;
+
+  int bufrow = row + screen->top;
+  if(bufrow >= screen->rows)
+    bufrow -= screen->rows;
+
+  return screen->buffer + (screen->cols * bufrow) + col;
 }
 
 static ScreenCell *alloc_buffer(VTermScreen *screen, int rows, int cols)
@@ -95,6 +106,26 @@ static ScreenCell *alloc_buffer(VTermScreen *screen, int rows, int cols)
   return new_buffer;
 }
 
+/* Store the active buffer with screen row 0 at buffer row 0 again */
+static void unrotate_buffer(VTermScreen *screen)
+{
+  if(!screen->top)
+    return;
+
+  int bufidx = screen->buffer == screen->buffers[BUFIDX_PRIMARY] ? BUFIDX_PRIMARY : BUFIDX_ALTSCREEN;
+  int toprows = screen->rows - screen->top;
+  size_t rowsize = sizeof(ScreenCell) * screen->cols;
+
+  ScreenCell *new_buffer = vterm_allocator_malloc(screen->vt, rowsize * screen->rows);
+  memcpy(new_buffer, screen->buffer + screen->top * screen->cols, rowsize * toprows);
+  memcpy(new_buffer + toprows * screen->cols, screen->buffer, rowsize * screen->top);
+
+  vterm_allocator_free(screen->vt, screen->buffer);
+  screen->buffers[bufidx] = new_buffer;
+  screen->buffer = new_buffer;
+  screen->top = 0;
+}
+
 static void damagerect(VTermScreen *screen, VTermRect rect)
 {
   VTermRect emit;
@@ -199,6 +230,37 @@ static int putglyph(VTermGlyphInfo *info, VTermPos pos, void *user)
   return 1;
 }
 
+static int putglyphrun(const uint32_t chars[], int count, VTermGlyphInfo *info, VTermPos pos, void *user)
+{
+  VTermScreen *screen = user;
+  ScreenCell *cell = getcell(screen, pos.row, pos.col);
+
+  if(!cell || pos.col + count > screen->cols)
+    return 0;
+
+  ScreenPen pen = screen->pen;
+  pen.protected_cell = info->protected_cell;
+  pen.dwl            = info->dwl;
+  pen.dhl            = info->dhl;
+
+  for(int i = 0; i < count; i++, cell++) {
+    cell->chars[0] = chars[i];
+    cell->chars[1] = 0;
+    cell->pen = pen;
+  }
+
+  VTermRect rect = {
+    .start_row = pos.row,
+    .end_row   = pos.row+1,
+    .start_col = pos.col,
+    .end_col   = pos.col+count,
+  };
+
+  damagerect(screen, rect);
+
+  return 1;
+}
+
 static void sb_pushline_from_row(VTermScreen *screen, int row)
 {
   VTermPos pos = { .row = row };
@@ -223,6 +285,15 @@ static int moverect_internal(VTermRect dest, VTermRect src, void *user)
   int cols = src.end_col - src.start_col;
   int downward = src.start_row - dest.start_row;
 
+  if(dest.start_col == 0 && src.start_col == 0 && cols == screen->cols &&
+     (downward > 0 ? dest.start_row == 0 && src.end_row == screen->rows
+                   : src.start_row == 0 && dest.end_row == screen->rows)) {
+    /* The whole screen moves vertically; rotate the ring of rows. The rows
+     * that come around to the other end are erased by the caller. */
+    screen->top = (screen->top + downward + screen->rows) % screen->rows;
+    return 1;
+  }
+
   int init_row, test_row, inc_row;
   if(downward < 0) {
     init_row = dest.end_row - 1;
@@ -445,6 +516,7 @@ static int settermprop(VTermProp prop, VTermValue *val, void *user)
     if(val->boolean && !screen->buffers[BUFIDX_ALTSCREEN])
       return 0;
 
+    unrotate_buffer(screen);
     screen->buffer = val->boolean ? screen->buffers[BUFIDX_ALTSCREEN] : screen->buffers[BUFIDX_PRIMARY];
     /* only send a damage event on disable; because during enable there's an
      * erase that sends a damage anyway
@@ -579,6 +651,8 @@ static int resize(int new_rows, int new_cols, VTermStateFields *fields, void *us
 {
   VTermScreen *screen = user;
 
+  unrotate_buffer(screen);
+
   int altscreen_active = (screen->buffers[BUFIDX_ALTSCREEN] && screen->buffer == screen->buffers[BUFIDX_ALTSCREEN]);
 
   int old_cols = screen->cols;
@@ -657,6 +731,7 @@ static VTermStateCallbacks state_cbs = {
   .bell        = &bell,
   .resize      = &resize,
   .setlineinfo = &setlineinfo,
+  .putglyphrun = &putglyphrun,
 };
 
 static VTermScreen *screen_new(VTerm *vt)
@@ -686,6 +761,7 @@ static VTermScreen *screen_new(VTerm *vt)
   screen->buffers[BUFIDX_PRIMARY] = alloc_buffer(screen, rows, cols);
 
   screen->buffer = screen->buffers[BUFIDX_PRIMARY];
+  screen->top = 0;
 
   screen->sb_buffer = vterm_allocator_malloc(screen->vt, sizeof(VTermScreenCell) * cols);
 
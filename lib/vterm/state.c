@@ -28,6 +28,31 @@ static void putglyph(VTermState *state, const uint32_t chars[], int width, VTerm
   DEBUG_LOG("libvterm: Unhandled putglyph U+%04x at (%d,%d)\n", chars[0], pos.col, pos.row);
 }
 
+static void putglyphrun(VTermState *state, const uint32_t chars[], int count, VTermPos pos)
+{
+  VTermGlyphInfo info = {
+    .chars = NULL,
+    .width = 1,
+    .protected_cell = state->protected_cell,
+    .dwl = state->lineinfo[pos.row].doublewidth,
+    .dhl = state->lineinfo[pos.row].doubleheight,
+  };
+
+  if(state->callbacks && state->callbacks->putglyphrun)
+    if((*state->callbacks->putglyphrun)(chars, count, &info, pos, state->cbdata))
+      return;
+
+  for(int i = 0; i < count; i++, pos.col++) {
+    uint32_t glyph[2] = { chars[i], 0 };
+    putglyph(state, glyph, 1, pos);
+  }
+}
+
+static bool is_printable_ascii(uint32_t codepoint)
+{
+  return codepoint >= 0x20 && codepoint < 0x7f;
+}
+
 static void updatecursor(VTermState *state, VTermPos *oldpos, int cancel_phantom)
 {
   if(state->pos.col == oldpos->col && state->pos.row == oldpos->row)
@@ -344,6 +369,41 @@ static int on_text(const char bytes[], size_t len, void *user)
   }
 
   for(; i < npoints; i++) {
+    // Printable ASCII is never combining and always a single cell wide, so
+    // a run of it is written out a row at a time. The last glyph of the run
+    // is left to the general path below, which deals with any combining
+    // characters that follow it and with saving it for a later combine.
+    if(!state->mode.insert && is_printable_ascii(codepoints[i])) {
+      int run_end = i + 1;
+      while(run_end < npoints && is_printable_ascii(codepoints[run_end]))
+        run_end++;
+
+      while(i < run_end - 1) {
+        if(state->at_phantom || state->pos.col + 1 > THISROWWIDTH(state)) {
+          linefeed(state);
+          state->pos.col = 0;
+          state->at_phantom = 0;
+          state->lineinfo[state->pos.row].continuation = 1;
+        }
+
+        int count = THISROWWIDTH(state) - state->pos.col;
+        if(count > run_end - 1 - i)
+          count = run_end - 1 - i;
+
+        putglyphrun(state, codepoints + i, count, state->pos);
+        i += count;
+
+        if(state->pos.col + count >= THISROWWIDTH(state)) {
+          state->pos.col = THISROWWIDTH(state) - 1;
+          if(state->mode.autowrap)
+            state->at_phantom = 1;
+        }
+        else {
+          state->pos.col += count;
+        }
+      }
+    }
+
     // Try to find combining characters following this
     int glyph_starts = i;
     int glyph_ends;
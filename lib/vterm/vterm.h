@@ -403,6 +403,11 @@ typedef struct {
   int (*bell)(void *user);
   int (*resize)(int rows, int cols, VTermStateFields *fields, void *user);
   int (*setlineinfo)(int row, const VTermLineInfo *newinfo, const VTermLineInfo *oldinfo, void *user);
+  /* Optional. A run of count single-width glyphs of one codepoint each,
+   * starting at pos and not crossing the end of the row. info->chars and
+   * info->width are unused. When absent, or it returns 0, putglyph is
+   * called for each glyph instead. */
+  int (*putglyphrun)(const uint32_t chars[], int count, VTermGlyphInfo *info, VTermPos pos, void *user);
 } VTermStateCallbacks;
 
 typedef struct {
@@ -285,6 +285,7 @@ void vterm_state_push_output_sprintf_CSI(VTermState *vts, const char *format, ..
 void vterm_screen_free(VTermScreen *screen);
 
 VTermEncoding *vterm_lookup_encoding(VTermEncodingType type, char designation);
+size_t vterm_ascii_span(const char bytes[], size_t len);
 
 int vterm_unicode_width(uint32_t codepoint);
 int vterm_unicode_is_combining(uint32_t codepoint);